@@ -0,0 +1,61 @@
+#include<branch_widener.h>
+
+#include<iostream>
+
+#include<TTree.h>
+
+antok::BranchWidener::~BranchWidener() {
+
+	for(unsigned int i = 0; i < _floatVectors.size(); ++i) {
+		delete _floatVectors[i];
+	}
+
+}
+
+void antok::BranchWidener::addFloat(const std::string& name, double* target) {
+
+	_floatNames.push_back(name);
+	_floats.push_back(0.);
+	_floatTargets.push_back(target);
+
+}
+
+void antok::BranchWidener::addShort(const std::string& name, int* target) {
+
+	_shortNames.push_back(name);
+	_shorts.push_back(0);
+	_shortTargets.push_back(target);
+
+}
+
+void antok::BranchWidener::addFloatVector(const std::string& name, std::vector<double>* target) {
+
+	_floatVectorNames.push_back(name);
+	_floatVectors.push_back(new std::vector<float>);
+	_floatVectorTargets.push_back(target);
+
+}
+
+bool antok::BranchWidener::setBranchAddresses(TTree* tree) {
+
+	for(unsigned int i = 0; i < _floatNames.size(); ++i) {
+		if(tree->SetBranchAddress(_floatNames[i].c_str(), &(_floats[i])) < 0) {
+			std::cerr<<"Could not set the address of the float branch \""<<_floatNames[i]<<"\"."<<std::endl;
+			return false;
+		}
+	}
+	for(unsigned int i = 0; i < _shortNames.size(); ++i) {
+		if(tree->SetBranchAddress(_shortNames[i].c_str(), &(_shorts[i])) < 0) {
+			std::cerr<<"Could not set the address of the short branch \""<<_shortNames[i]<<"\"."<<std::endl;
+			return false;
+		}
+	}
+	for(unsigned int i = 0; i < _floatVectorNames.size(); ++i) {
+		if(tree->SetBranchAddress(_floatVectorNames[i].c_str(), &(_floatVectors[i])) < 0) {
+			std::cerr<<"Could not set the address of the std::vector<float> branch \""<<_floatVectorNames[i]<<"\"."<<std::endl;
+			return false;
+		}
+	}
+	return true;
+
+}
@@ -0,0 +1,64 @@
+#ifndef ANTOK_BRANCH_WIDENER_H
+#define ANTOK_BRANCH_WIDENER_H
+
+#include<string>
+#include<vector>
+
+class TTree;
+
+namespace antok {
+
+	// Reads compact input branches (float, Float16_t, short, std::vector<float>)
+	// into buffers of their own type and widens them into the double, int and
+	// std::vector<double> slots of Data after every read of the input tree.
+	// All branches have to be added before setBranchAddresses() is called, as
+	// the buffers must not move afterwards.
+	class BranchWidener {
+
+	  public:
+
+		BranchWidener() { }
+		~BranchWidener();
+
+		// Float16_t is a float in memory, only the compression on disk differs
+		void addFloat(const std::string& name, double* target);
+		void addShort(const std::string& name, int* target);
+		void addFloatVector(const std::string& name, std::vector<double>* target);
+
+		bool setBranchAddresses(TTree* tree);
+
+		void widen() {
+			const unsigned int nFloats = _floats.size();
+			for(unsigned int i = 0; i < nFloats; ++i) {
+				*(_floatTargets[i]) = _floats[i];
+			}
+			const unsigned int nShorts = _shorts.size();
+			for(unsigned int i = 0; i < nShorts; ++i) {
+				*(_shortTargets[i]) = _shorts[i];
+			}
+			for(unsigned int i = 0; i < _floatVectors.size(); ++i) {
+				_floatVectorTargets[i]->assign(_floatVectors[i]->begin(), _floatVectors[i]->end());
+			}
+		}
+
+		bool empty() const { return _floatNames.empty() and _shortNames.empty() and _floatVectorNames.empty(); }
+
+	  private:
+
+		std::vector<std::string> _floatNames;
+		std::vector<float> _floats;
+		std::vector<double*> _floatTargets;
+
+		std::vector<std::string> _shortNames;
+		std::vector<short> _shorts;
+		std::vector<int*> _shortTargets;
+
+		std::vector<std::string> _floatVectorNames;
+		std::vector<std::vector<float>*> _floatVectors;
+		std::vector<std::vector<double>*> _floatVectorTargets;
+
+	};
+
+}
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef ANTOK_CUT_H
 #define ANTOK_CUT_H
 
+#include<limits>
 #include<string>
 #include<sstream>
+#include<vector>
 
 #include<event.h>
 
@@ -39,6 +41,7 @@ namespace antok {
 
 	namespace cuts {
 
+		template<typename T>
 		class RangeCut : public Cut {
 
 		  public:
@@ -47,9 +50,9 @@ namespace antok {
 			         const std::string& longname,
 			         const std::string& abbreviation,
 			         bool* outAddr,
-			         double* lowerBoundAddr,
-			         double* upperBoundAddr,
-			         double* valueAddr,
+			         T* lowerBoundAddr,
+			         T* upperBoundAddr,
+			         T* valueAddr,
 			         int mode)
 				: Cut(shortname, longname, abbreviation, outAddr),
 				  _lowerBoundAddr(lowerBoundAddr),
@@ -111,9 +114,9 @@ namespace antok {
 
 		  private:
 
-			double* _lowerBoundAddr;
-			double* _upperBoundAddr;
-			double* _valueAddr;
+			T* _lowerBoundAddr;
+			T* _upperBoundAddr;
+			T* _valueAddr;
 			int _mode;
 
 		};
@@ -233,6 +236,7 @@ namespace antok {
 
 		};
 
+		template<typename T>
 		class TriggerMaskCut: public Cut {
 
 		  public:
@@ -241,8 +245,8 @@ namespace antok {
 			               const std::string& longname,
 			               const std::string& abbreviation,
 			               bool* outAddr,
-			               int* maskAddr,
-			               int* triggerAddr,
+			               T* maskAddr,
+			               T* triggerAddr,
 			               int mode)
 				: Cut(shortname, longname, abbreviation, outAddr),
 				  _maskAddr(maskAddr),
@@ -252,7 +256,7 @@ namespace antok {
 			bool operator() () {
 				switch(_mode) {
 					case 0:
-						(*_outAddr) = (*_maskAddr)&(*_triggerAddr);
+						(*_outAddr) = ((*_maskAddr)&(*_triggerAddr)) != 0;
 						return true;
 				}
 				return false;
@@ -270,12 +274,107 @@ namespace antok {
 
 		  private:
 
-			int* _maskAddr;
-			int* _triggerAddr;
+			T* _maskAddr;
+			T* _triggerAddr;
 			int _mode;
 
 		};
 
+		// Cut on how many entries of a std::vector<double> lie in a range.
+		// The counting loops compare without branching, so that the compiler
+		// can vectorize them over the vector's contiguous storage.
+		class VectorRangeCut : public Cut {
+
+		  public:
+
+			VectorRangeCut(const std::string& shortname,
+			               const std::string& longname,
+			               const std::string& abbreviation,
+			               bool* outAddr,
+			               double* lowerBoundAddr,
+			               double* upperBoundAddr,
+			               std::vector<double>* valuesAddr,
+			               bool inclusive,
+			               int quantifier,
+			               int* minCountAddr,
+			               int* maxCountAddr)
+				: Cut(shortname, longname, abbreviation, outAddr),
+				  _lowerBoundAddr(lowerBoundAddr),
+				  _upperBoundAddr(upperBoundAddr),
+				  _valuesAddr(valuesAddr),
+				  _inclusive(inclusive),
+				  _quantifier(quantifier),
+				  _minCountAddr(minCountAddr),
+				  _maxCountAddr(maxCountAddr) { }
+
+			bool operator() () {
+				const unsigned int size = _valuesAddr->size();
+				const double* values = size > 0 ? &((*_valuesAddr)[0]) : 0;
+				const double lowerBound = _lowerBoundAddr ? (*_lowerBoundAddr) : -std::numeric_limits<double>::infinity();
+				const double upperBound = _upperBoundAddr ? (*_upperBoundAddr) : std::numeric_limits<double>::infinity();
+				int count = 0;
+				if(_inclusive) {
+					for(unsigned int i = 0; i < size; ++i) {
+						count += (values[i] >= lowerBound) & (values[i] <= upperBound);
+					}
+				} else {
+					for(unsigned int i = 0; i < size; ++i) {
+						count += (values[i] > lowerBound) & (values[i] < upperBound);
+					}
+				}
+				switch(_quantifier) {
+					case 0:
+						// any
+						(*_outAddr) = count > 0;
+						return true;
+					case 1:
+						// all
+						(*_outAddr) = count == (int)size;
+						return true;
+					case 2:
+						// count
+						(*_outAddr) = (count >= (*_minCountAddr)) and ((not _maxCountAddr) or (count <= (*_maxCountAddr)));
+						return true;
+				}
+				return false;
+			}
+
+			bool operator==(const Cut& arhs) {
+				const VectorRangeCut* rhs = dynamic_cast<const VectorRangeCut*>(&arhs);
+				if(not rhs) {
+					return false;
+				}
+				if((this->_lowerBoundAddr == 0) != (rhs->_lowerBoundAddr == 0) or
+				   (this->_upperBoundAddr == 0) != (rhs->_upperBoundAddr == 0) or
+				   (this->_minCountAddr == 0) != (rhs->_minCountAddr == 0) or
+				   (this->_maxCountAddr == 0) != (rhs->_maxCountAddr == 0))
+				{
+					return false;
+				}
+				if((this->_lowerBoundAddr and (*this->_lowerBoundAddr != *rhs->_lowerBoundAddr)) or
+				   (this->_upperBoundAddr and (*this->_upperBoundAddr != *rhs->_upperBoundAddr)) or
+				   (this->_minCountAddr and (*this->_minCountAddr != *rhs->_minCountAddr)) or
+				   (this->_maxCountAddr and (*this->_maxCountAddr != *rhs->_maxCountAddr)))
+				{
+					return false;
+				}
+				return (this->_valuesAddr == rhs->_valuesAddr) and
+				       (this->_inclusive == rhs->_inclusive) and
+				       (this->_quantifier == rhs->_quantifier);
+			}
+
+		  private:
+
+			double* _lowerBoundAddr;
+			double* _upperBoundAddr;
+			std::vector<double>* _valuesAddr;
+			bool _inclusive;
+			int _quantifier;
+			int* _minCountAddr;
+			int* _maxCountAddr;
+
+		};
+
 		class CutGroup : public Cut {
 
 		  public:
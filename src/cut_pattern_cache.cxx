@@ -0,0 +1,126 @@
+#include<cut_pattern_cache.h>
+
+#include<cstring>
+#include<fstream>
+#include<iostream>
+
+const char* antok::CutPatternCache::__magic = "ANTOKCUT";
+const unsigned int antok::CutPatternCache::__version = 1;
+
+antok::CutPatternCache::CutPatternCache(const std::string& fileName, ULong64_t configHash, unsigned int nCuts)
+	: _fileName(fileName),
+	  _configHash(configHash),
+	  _nCuts(nCuts),
+	  _reading(false),
+	  _currentRun(0),
+	  _positionInRun(0),
+	  _nRecorded(0) { }
+
+bool antok::CutPatternCache::load(Long64_t nEntries) {
+
+	_reading = false;
+	_runs.clear();
+	std::ifstream inFile(_fileName.c_str(), std::ios::in | std::ios::binary);
+	if(not inFile.is_open()) {
+		return false;
+	}
+	char magic[8];
+	unsigned int version = 0;
+	ULong64_t configHash = 0;
+	ULong64_t nStoredEntries = 0;
+	unsigned int nCuts = 0;
+	ULong64_t nRuns = 0;
+	inFile.read(magic, 8);
+	inFile.read((char*)&version, sizeof(version));
+	inFile.read((char*)&configHash, sizeof(configHash));
+	inFile.read((char*)&nStoredEntries, sizeof(nStoredEntries));
+	inFile.read((char*)&nCuts, sizeof(nCuts));
+	inFile.read((char*)&nRuns, sizeof(nRuns));
+	if(not inFile.good() or std::strncmp(magic, __magic, 8) != 0 or version != __version) {
+		std::cerr<<"Warning: cut pattern sidecar \""<<_fileName<<"\" is corrupt, ignoring it."<<std::endl;
+		return false;
+	}
+	if(configHash != _configHash or nCuts != _nCuts or nStoredEntries != (ULong64_t)nEntries) {
+		std::cout<<"Cut pattern sidecar \""<<_fileName<<"\" was made with a different configuration or input, ignoring it."<<std::endl;
+		return false;
+	}
+	_runs.resize(nRuns);
+	ULong64_t nEntriesInRuns = 0;
+	for(ULong64_t i = 0; i < nRuns; ++i) {
+		Long64_t cutPattern = 0;
+		unsigned int length = 0;
+		inFile.read((char*)&cutPattern, sizeof(cutPattern));
+		inFile.read((char*)&length, sizeof(length));
+		_runs[i] = std::pair<long, unsigned int>((long)cutPattern, length);
+		nEntriesInRuns += length;
+	}
+	if(not inFile.good() or nEntriesInRuns != nStoredEntries) {
+		std::cerr<<"Warning: cut pattern sidecar \""<<_fileName<<"\" is truncated, ignoring it."<<std::endl;
+		_runs.clear();
+		return false;
+	}
+	_currentRun = 0;
+	_positionInRun = 0;
+	_reading = true;
+	return true;
+
+}
+
+bool antok::CutPatternCache::next(long& cutPattern) {
+
+	while(_currentRun < _runs.size() and _positionInRun >= _runs[_currentRun].second) {
+		++_currentRun;
+		_positionInRun = 0;
+	}
+	if(_currentRun >= _runs.size()) {
+		std::cerr<<"Ran out of entries in cut pattern sidecar \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	cutPattern = _runs[_currentRun].first;
+	++_positionInRun;
+	return true;
+
+}
+
+void antok::CutPatternCache::record(long cutPattern) {
+
+	if((not _runs.empty()) and _runs.back().first == cutPattern and _runs.back().second < 0xffffffff) {
+		++(_runs.back().second);
+	} else {
+		_runs.push_back(std::pair<long, unsigned int>(cutPattern, 1));
+	}
+	++_nRecorded;
+
+}
+
+bool antok::CutPatternCache::write() const {
+
+	if(_reading) {
+		return true;
+	}
+	std::ofstream outFile(_fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(not outFile.is_open()) {
+		std::cerr<<"Could not open cut pattern sidecar \""<<_fileName<<"\" for writing."<<std::endl;
+		return false;
+	}
+	ULong64_t nRuns = _runs.size();
+	outFile.write(__magic, 8);
+	outFile.write((const char*)&__version, sizeof(__version));
+	outFile.write((const char*)&_configHash, sizeof(_configHash));
+	outFile.write((const char*)&_nRecorded, sizeof(_nRecorded));
+	outFile.write((const char*)&_nCuts, sizeof(_nCuts));
+	outFile.write((const char*)&nRuns, sizeof(nRuns));
+	for(unsigned int i = 0; i < _runs.size(); ++i) {
+		Long64_t cutPattern = _runs[i].first;
+		unsigned int length = _runs[i].second;
+		outFile.write((const char*)&cutPattern, sizeof(cutPattern));
+		outFile.write((const char*)&length, sizeof(length));
+	}
+	if(not outFile.good()) {
+		std::cerr<<"Error while writing cut pattern sidecar \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	std::cout<<"Wrote "<<_nRecorded<<" cut patterns in "<<nRuns<<" runs to \""<<_fileName<<"\"."<<std::endl;
+	return true;
+
+}
@@ -0,0 +1,50 @@
+#ifndef ANTOK_CUT_PATTERN_CACHE_H
+#define ANTOK_CUT_PATTERN_CACHE_H
+
+#include<string>
+#include<utility>
+#include<vector>
+
+#include<Rtypes.h>
+
+namespace antok {
+
+	// Run-length encoded sidecar file holding the cut pattern of every
+	// input entry together with a hash of the configuration which produced
+	// it. If a later run finds a sidecar with a matching hash, the cut
+	// patterns are read from it instead of being evaluated again.
+	class CutPatternCache {
+
+	  public:
+
+		CutPatternCache(const std::string& fileName, ULong64_t configHash, unsigned int nCuts);
+
+		bool load(Long64_t nEntries);
+
+		bool isReading() const { return _reading; }
+
+		bool next(long& cutPattern);
+		void record(long cutPattern);
+
+		bool write() const;
+
+	  private:
+
+		static const char* __magic;
+		static const unsigned int __version;
+
+		std::string _fileName;
+		ULong64_t _configHash;
+		unsigned int _nCuts;
+		bool _reading;
+
+		std::vector<std::pair<long, unsigned int> > _runs;
+		unsigned int _currentRun;
+		unsigned int _positionInRun;
+		ULong64_t _nRecorded;
+
+	};
+
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include<TTree.h>
 
 #include<cut.hpp>
+#include<cut_pattern_cache.h>
+#include<tree_writer.h>
 
 antok::Cutter* antok::Cutter::_cutter = 0;
 
@@ -18,15 +20,28 @@ antok::Cutter* antok::Cutter::instance() {
 
 bool antok::Cutter::cut() {
 
+	if(_cutPatternCache and _cutPatternCache->isReading()) {
+		if(not _cutPatternCache->next(_cutPattern)) {
+			return false;
+		}
+		for(unsigned int i = 0; i < _cuts.size(); ++i) {
+			(*(_cuts[i].second)) = ((_cutPattern>>i)&1);
+		}
+		return true;
+	}
+
 	bool success = true;
 	_cutPattern = 0;
 	for(unsigned int i = 0; i < _cuts.size(); ++i) {
 		success = success and (*(_cuts[i].first))();
 		bool result = (*(_cuts[i].second));
 		if(result) {
-			_cutPattern += (1<<i);
+			_cutPattern += (1L<<i);
 		}
 	}
+	if(_cutPatternCache) {
+		_cutPatternCache->record(_cutPattern);
+	}
 	return success;
 
 };
@@ -52,15 +67,20 @@ const std::vector<antok::Cut*>& antok::Cutter::getCutsForCutTrain(std::string cu
 
 };
 
-bool antok::Cutter::cutOnInCutmask(long mask, const antok::Cut* cut) const {
+unsigned int antok::Cutter::getCutIndex(const antok::Cut* cut) const {
 
-	for(unsigned int i = 0; i < _cuts.size(); ++i) {
-		const antok::Cut* innerCut = _cuts[i].first;
-		if(cut == innerCut) {
-			return ((mask>>i)&1);
-		}
+	for(unsigned int i = _cutIndices.size(); i < _cuts.size(); ++i) {
+		_cutIndices[_cuts[i].first] = i;
 	}
-	assert(false);
+	std::map<const antok::Cut*, unsigned int>::const_iterator index_it = _cutIndices.find(cut);
+	assert(index_it != _cutIndices.end());
+	return index_it->second;
+
+}
+
+bool antok::Cutter::cutOnInCutmask(long mask, const antok::Cut* cut) const {
+
+	return ((mask>>getCutIndex(cut))&1);
 
 }
 
@@ -70,11 +90,7 @@ long antok::Cutter::getCutmaskForNames(std::vector<std::string> names) const {
 	for(unsigned int i = 0; i < names.size(); ++i) {
 		std::map<std::string, antok::Cut*>::const_iterator cutsMap_it = _cutsMap.find(names[i]);
 		assert(cutsMap_it != _cutsMap.end());
-		const antok::Cut* cut = cutsMap_it->second;
-		unsigned int index = 0;
-		for( ; _cuts[index].first != cut && index < _cuts.size(); ++index);
-		assert(index < _cuts.size());
-		cutmask += 1<<index;
+		cutmask += 1L<<getCutIndex(cutsMap_it->second);
 	}
 	return cutmask;
 
@@ -148,13 +164,8 @@ const std::map<std::string, std::vector<long> >& antok::Cutter::getCutmasksAllCu
 			long cutmaskTemplate = getAllCutsCutmaskForCutTrain(cutTrainName);
 			const std::vector<antok::Cut*>& cuts = cutTrainsCutOrder_it->second;
 			for(unsigned int i = 0; i < cuts.size(); ++i) {
-				for(unsigned int j = 0; j < _cuts.size(); ++j) {
-					if(cuts[i] == _cuts[j].first) {
-						long cutmask = cutmaskTemplate - (1<<j);
-						_singleOffCutmasksCache[cutTrainName].push_back(cutmask);
-						break;
-					}
-				}
+				long cutmask = cutmaskTemplate - (1L<<getCutIndex(cuts[i]));
+				_singleOffCutmasksCache[cutTrainName].push_back(cutmask);
 			}
 		}
 
@@ -175,13 +186,8 @@ const std::map<std::string, std::vector<long> >& antok::Cutter::getCutmasksAllCu
 			const std::string& cutTrainName = cutTrainsCutOrder_it->first;
 			const std::vector<antok::Cut*>& cuts = cutTrainsCutOrder_it->second;
 			for(unsigned int i = 0; i < cuts.size(); ++i) {
-				for(unsigned int j = 0; j < _cuts.size(); ++j) {
-					if(cuts[i] == _cuts[j].first) {
-						long cutmask = 1<<j;
-						_singleOnCutmasksCache[cutTrainName].push_back(cutmask);
-						break;
-					}
-				}
+				long cutmask = 1L<<getCutIndex(cuts[i]);
+				_singleOnCutmasksCache[cutTrainName].push_back(cutmask);
 			}
 		}
 
@@ -202,13 +208,36 @@ bool antok::Cutter::cutInCutTrain(std::string cutName, std::string cutTrainName)
 
 bool antok::Cutter::fillOutTrees() const {
 
+	if(_treeWriter == 0) {
+		return true;
+	}
+	return _treeWriter->fill(_cutPattern);
+
+}
+
+bool antok::Cutter::cutPatternsFromCache() const {
+
+	return (_cutPatternCache and _cutPatternCache->isReading());
+
+}
+
+bool antok::Cutter::cutPatternPertinent(long cutPattern) const {
+
+	if(_treeWriter == 0) {
+		return false;
+	}
+	return _treeWriter->acceptsCutPattern(cutPattern);
+
+}
+
+bool antok::Cutter::finish() {
+
 	bool success = true;
-	for(unsigned int i = 0; i < _treesToFill.size(); ++i) {
-		TTree* tree = _treesToFill[i].first;
-		long mask = _treesToFill[i].second;
-		if((mask&_cutPattern) == mask) {
-			success = success and (tree->Fill() > 0);
-		}
+	if(_treeWriter) {
+		success = _treeWriter->finish() and success;
+	}
+	if(_cutPatternCache) {
+		success = _cutPatternCache->write() and success;
 	}
 	return success;
 
@@ -216,12 +245,7 @@ bool antok::Cutter::fillOutTrees() const {
 
 const bool* antok::Cutter::getCutResult(antok::Cut* cut) const {
 
-	for(unsigned int i = 0; i < _cuts.size(); ++i) {
-		if(cut == _cuts[i].first) {
-			return _cuts[i].second;
-		}
-	}
-	assert(false);
+	return _cuts[getCutIndex(cut)].second;
 
 }
 
@@ -10,6 +10,8 @@ class TTree;
 namespace antok {
 
 	class Cut;
+	class CutPatternCache;
+	class TreeWriter;
 
 	class Cutter {
 
@@ -25,6 +27,11 @@ namespace antok {
 
 		bool fillOutTrees() const;
 
+		bool cutPatternsFromCache() const;
+		bool cutPatternPertinent(long cutPattern) const;
+
+		bool finish();
+
 		long getCutmaskForNames(std::vector<std::string> names) const;
 
 		long getAllCutsCutmaskForCutTrain(std::string cutTrainName) const;
@@ -44,8 +51,12 @@ namespace antok {
 
 	  private:
 
+		unsigned int getCutIndex(const antok::Cut* cut) const;
+
 		Cutter()
-			: _cutPattern(0) { };
+			: _cutPattern(0),
+			  _treeWriter(0),
+			  _cutPatternCache(0) { };
 
 		static Cutter* _cutter;
 
@@ -60,9 +71,12 @@ namespace antok {
 		std::map<std::string, std::vector<long> > _singleOffCutmasksCache;
 		std::map<std::string, std::vector<long> > _singleOnCutmasksCache;
 
-		std::vector<std::pair<TTree*, long> > _treesToFill;
+		antok::TreeWriter* _treeWriter;
+		antok::CutPatternCache* _cutPatternCache;
 
 		std::vector<std::pair<antok::Cut*, bool*> > _cuts;
+		// position of every cut in _cuts, extended when cuts were added
+		mutable std::map<const antok::Cut*, unsigned int> _cutIndices;
 
 	};
 
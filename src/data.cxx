@@ -81,6 +81,7 @@ namespace antok {
 
 	template<>
 	double* antok::Data::getAddr<double>(std::string name) {
+		requestedNames.insert(name);
 		if(doubles.count(name) < 1) {
 			return 0;
 		}
@@ -89,6 +90,7 @@ namespace antok {
 
 	template<>
 	int* antok::Data::getAddr<int>(std::string name) {
+		requestedNames.insert(name);
 		if(ints.count(name) < 1) {
 			return 0;
 		}
@@ -97,6 +99,7 @@ namespace antok {
 
 	template<>
 	Long64_t* antok::Data::getAddr<Long64_t>(std::string name) {
+		requestedNames.insert(name);
 		if(long64_ts.count(name) < 1) {
 			return 0;
 		}
@@ -105,6 +108,7 @@ namespace antok {
 
 	template<>
 	std::vector<double>* antok::Data::getAddr<std::vector<double> >(std::string name) {
+		requestedNames.insert(name);
 		if(doubleVectors.count(name) < 1) {
 			return 0;
 		}
@@ -113,6 +117,7 @@ namespace antok {
 
 	template<>
 	TLorentzVector* antok::Data::getAddr<TLorentzVector>(std::string name) {
+		requestedNames.insert(name);
 		if(lorentzVectors.count(name) < 1) {
 			return 0;
 		}
@@ -121,6 +126,7 @@ namespace antok {
 
 	template<>
 	TVector3* antok::Data::getAddr<TVector3>(std::string name) {
+		requestedNames.insert(name);
 		if(vectors.count(name) < 1) {
 			return 0;
 		}
@@ -129,6 +135,12 @@ namespace antok {
 
 }
 
+std::set<std::string> antok::Data::takeRequestedNames() {
+	std::set<std::string> names;
+	names.swap(requestedNames);
+	return names;
+}
+
 std::string antok::Data::getType(std::string name) {
 	if(global_map.count(name) > 0) {
 		return global_map[name];
@@ -2,6 +2,7 @@
 #define ANTOK_DATA_H
 
 #include<map>
+#include<set>
 #include<string>
 #include<utility>
 
@@ -25,6 +26,10 @@ namespace antok {
 
 		template<typename T> T* getAddr(std::string name);
 
+		// the names asked for with getAddr since the last call, to see which
+		// quantities a function or a plot uses
+		std::set<std::string> takeRequestedNames();
+
 		std::string getType(std::string name);
 		bool isVector(std::string name);
 
@@ -45,6 +50,8 @@ namespace antok {
 		std::map<std::string, TLorentzVector> lorentzVectors;
 		std::map<std::string, TVector3> vectors;
 
+		std::set<std::string> requestedNames;
+
 
 	};
 
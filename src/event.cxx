@@ -3,6 +3,7 @@
 #include<basic_calcs.h>
 #include<constants.h>
 #include<functions.hpp>
+#include<quantity_cache.h>
 
 antok::Event* antok::Event::_event = 0;
 
@@ -19,7 +20,34 @@ bool antok::Event::update() {
 	for(unsigned int i = 0; i < _functions.size(); ++i) {
 		success = success and (*_functions[i])();
 	}
+	if(_quantityCache) {
+		success = _quantityCache->fill() and success;
+	}
 	return success;
 
 };
 
+bool antok::Event::writesQuantityCache() const {
+
+	return (_quantityCache and _quantityCache->isWriting());
+
+}
+
+bool antok::Event::finish() {
+
+	if(_quantityCache == 0) {
+		return true;
+	}
+	return _quantityCache->finish();
+
+}
+
+bool antok::Event::resetForNextInput() {
+
+	bool success = true;
+	for(unsigned int i = 0; i < _functions.size(); ++i) {
+		success = _functions[i]->resetForNextInput() and success;
+	}
+	return success;
+
+}
@@ -7,6 +7,7 @@ namespace antok {
 
 	class Function;
 	class Initializer;
+	class QuantityCache;
 
 	class Event {
 
@@ -18,14 +19,24 @@ namespace antok {
 
 		bool update();
 
+		bool writesQuantityCache() const;
+
+		bool finish();
+
+		// after switching the input file
+		bool resetForNextInput();
+
 	  private:
 
-		Event() { };
+		Event()
+			: _quantityCache(0) { };
 
 		static Event* _event;
 
 		std::vector<antok::Function*> _functions;
 
+		antok::QuantityCache* _quantityCache;
+
 	};
 
 }
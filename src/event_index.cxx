@@ -0,0 +1,238 @@
+#include<event_index.h>
+
+#include<algorithm>
+#include<cstdlib>
+#include<cstring>
+#include<fcntl.h>
+#include<fstream>
+#include<iostream>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include<TFile.h>
+#include<TTree.h>
+
+const char* antok::EventIndex::__magic = "ANTOKIDX";
+const unsigned int antok::EventIndex::__version = 1;
+
+namespace {
+
+	struct __header {
+		char magic[8];
+		UInt_t version;
+		UInt_t nFiles;
+		ULong64_t nEvents;
+		// the file names follow the header, padded to 8 bytes, then the records
+		ULong64_t fileNamesSize;
+	};
+
+	bool __recordLess(const antok::EventIndex::eventRecord& lhs, const antok::EventIndex::eventRecord& rhs) {
+		if(lhs.run != rhs.run) {
+			return lhs.run < rhs.run;
+		}
+		if(lhs.spill != rhs.spill) {
+			return lhs.spill < rhs.spill;
+		}
+		return lhs.eventNumber < rhs.eventNumber;
+	}
+
+	bool __runLess(const antok::EventIndex::eventRecord& lhs, const antok::EventIndex::eventRecord& rhs) {
+		return lhs.run < rhs.run;
+	}
+
+	ULong64_t __padded(ULong64_t size) {
+		return (size + 7) & ~((ULong64_t)7);
+	}
+
+}
+
+antok::EventIndex::EventIndex(const std::string& fileName)
+	: _fileName(fileName),
+	  _nEvents(0),
+	  _mapping(0),
+	  _mappingSize(0),
+	  _records(0) { }
+
+antok::EventIndex::~EventIndex() {
+
+	if(_mapping) {
+		munmap(_mapping, _mappingSize);
+	}
+
+}
+
+bool antok::EventIndex::build(const std::string& fileName,
+                              const std::vector<std::string>& inFileNames,
+                              const std::string& treeName,
+                              const std::string& runBranchName,
+                              const std::string& spillBranchName,
+                              const std::string& eventNumberBranchName)
+{
+
+	std::vector<eventRecord> records;
+	std::string fileNames;
+	for(unsigned int file_i = 0; file_i < inFileNames.size(); ++file_i) {
+		// the index is used from other directories
+		char* path = realpath(inFileNames[file_i].c_str(), 0);
+		if(path == 0) {
+			std::cerr<<"Could not find input file \""<<inFileNames[file_i]<<"\" for the event index."<<std::endl;
+			return false;
+		}
+		const std::string inFileName = path;
+		free(path);
+		TFile* inFile = TFile::Open(inFileName.c_str(), "READ");
+		if(inFile == 0) {
+			std::cerr<<"Could not open input file \""<<inFileNames[file_i]<<"\" for the event index."<<std::endl;
+			return false;
+		}
+		TTree* inTree = dynamic_cast<TTree*>(inFile->Get(treeName.c_str()));
+		if(inTree == 0) {
+			std::cerr<<"Could not find TTree \""<<treeName<<"\" in \""<<inFileNames[file_i]<<"\"."<<std::endl;
+			inFile->Close();
+			delete inFile;
+			return false;
+		}
+		eventRecord record;
+		std::memset(&record, 0, sizeof(record));
+		record.file = file_i;
+		// only the three identifying branches are read
+		inTree->SetBranchStatus("*", false);
+		inTree->SetBranchStatus(runBranchName.c_str(), true);
+		inTree->SetBranchStatus(spillBranchName.c_str(), true);
+		inTree->SetBranchStatus(eventNumberBranchName.c_str(), true);
+		if(inTree->SetBranchAddress(runBranchName.c_str(), &record.run) < 0 or
+		   inTree->SetBranchAddress(spillBranchName.c_str(), &record.spill) < 0 or
+		   inTree->SetBranchAddress(eventNumberBranchName.c_str(), &record.eventNumber) < 0)
+		{
+			std::cerr<<"Could not read the int branches \""<<runBranchName<<"\" and \""<<spillBranchName<<"\" "
+			         <<"and the Long64_t branch \""<<eventNumberBranchName<<"\" of \""<<inFileNames[file_i]<<"\"."<<std::endl;
+			inFile->Close();
+			delete inFile;
+			return false;
+		}
+		const Long64_t nEntries = inTree->GetEntries();
+		records.reserve(records.size() + nEntries);
+		for(Long64_t entry = 0; entry < nEntries; ++entry) {
+			if(inTree->GetEntry(entry) <= 0) {
+				std::cerr<<"Could not read entry "<<entry<<" of \""<<inFileNames[file_i]<<"\"."<<std::endl;
+				inFile->Close();
+				delete inFile;
+				return false;
+			}
+			record.entry = entry;
+			records.push_back(record);
+		}
+		inFile->Close();
+		delete inFile;
+		fileNames.append(inFileName);
+		fileNames.push_back('\0');
+	}
+	std::stable_sort(records.begin(), records.end(), __recordLess);
+
+	__header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, __magic, 8);
+	header.version = __version;
+	header.nFiles = inFileNames.size();
+	header.nEvents = records.size();
+	header.fileNamesSize = fileNames.size();
+	fileNames.resize(__padded(fileNames.size()), '\0');
+
+	std::ofstream outFile(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(not outFile.is_open()) {
+		std::cerr<<"Could not open event index \""<<fileName<<"\" for writing."<<std::endl;
+		return false;
+	}
+	outFile.write((const char*)&header, sizeof(header));
+	outFile.write(fileNames.data(), fileNames.size());
+	if(not records.empty()) {
+		outFile.write((const char*)&records[0], records.size() * sizeof(eventRecord));
+	}
+	if(not outFile.good()) {
+		std::cerr<<"Could not write event index \""<<fileName<<"\"."<<std::endl;
+		return false;
+	}
+	std::cout<<"Wrote event index \""<<fileName<<"\" with "<<records.size()<<" events from "<<inFileNames.size()<<" files."<<std::endl;
+	return true;
+
+}
+
+bool antok::EventIndex::open() {
+
+	const int descriptor = ::open(_fileName.c_str(), O_RDONLY);
+	if(descriptor < 0) {
+		std::cerr<<"Could not open event index \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	struct stat fileStatus;
+	if(fstat(descriptor, &fileStatus) != 0 or (size_t)fileStatus.st_size < sizeof(__header)) {
+		std::cerr<<"Event index \""<<_fileName<<"\" is corrupt."<<std::endl;
+		close(descriptor);
+		return false;
+	}
+	_mappingSize = fileStatus.st_size;
+	_mapping = mmap(0, _mappingSize, PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if(_mapping == MAP_FAILED) {
+		std::cerr<<"Could not map event index \""<<_fileName<<"\"."<<std::endl;
+		_mapping = 0;
+		return false;
+	}
+
+	const __header* header = (const __header*)_mapping;
+	const char* fileNames = (const char*)_mapping + sizeof(__header);
+	const ULong64_t recordsOffset = sizeof(__header) + __padded(header->fileNamesSize);
+	if(std::strncmp(header->magic, __magic, 8) != 0 or header->version != __version or
+	   recordsOffset + header->nEvents * sizeof(eventRecord) != _mappingSize)
+	{
+		std::cerr<<"Event index \""<<_fileName<<"\" is corrupt or of another version."<<std::endl;
+		return false;
+	}
+	_fileNames.clear();
+	for(ULong64_t position = 0; position < header->fileNamesSize; position += _fileNames.back().size() + 1) {
+		_fileNames.push_back(std::string(fileNames + position));
+	}
+	if(_fileNames.size() != header->nFiles) {
+		std::cerr<<"Event index \""<<_fileName<<"\" is corrupt."<<std::endl;
+		return false;
+	}
+	_nEvents = header->nEvents;
+	_records = (const eventRecord*)((const char*)_mapping + recordsOffset);
+	return true;
+
+}
+
+bool antok::EventIndex::find(Int_t run, Int_t spill, Long64_t eventNumber, std::vector<antok::EventIndex::eventLocation>& locations) const {
+
+	if(_records == 0) {
+		std::cerr<<"Trying to search event index \""<<_fileName<<"\" before opening it."<<std::endl;
+		return false;
+	}
+	const eventRecord* begin = _records;
+	const eventRecord* end = _records + _nEvents;
+	eventRecord key;
+	std::memset(&key, 0, sizeof(key));
+	key.run = run;
+	key.spill = spill;
+	key.eventNumber = eventNumber;
+	if(spill >= 0) {
+		begin = std::lower_bound(begin, end, key, __recordLess);
+		end = std::upper_bound(begin, end, key, __recordLess);
+	} else {
+		begin = std::lower_bound(begin, end, key, __runLess);
+		end = std::upper_bound(begin, end, key, __runLess);
+	}
+	const unsigned int nLocations = locations.size();
+	for(const eventRecord* record = begin; record != end; ++record) {
+		if(record->eventNumber != eventNumber) {
+			continue;
+		}
+		eventLocation location;
+		location.fileName = _fileNames[record->file];
+		location.entry = record->entry;
+		locations.push_back(location);
+	}
+	return (locations.size() > nLocations);
+
+}
@@ -0,0 +1,67 @@
+#ifndef ANTOK_EVENT_INDEX_H
+#define ANTOK_EVENT_INDEX_H
+
+#include<string>
+#include<vector>
+
+#include<Rtypes.h>
+
+namespace antok {
+
+	// Sorted index from (run, spill, event number) to (input file, entry),
+	// written once over a set of input files and memory mapped for lookups,
+	// so picking single events needs neither a scan nor loading the index.
+	class EventIndex {
+
+	  public:
+
+		struct eventRecord {
+			Int_t run;
+			Int_t spill;
+			Long64_t eventNumber;
+			Long64_t entry;
+			UInt_t file;
+			UInt_t reserved;
+		};
+
+		struct eventLocation {
+			std::string fileName;
+			Long64_t entry;
+		};
+
+		EventIndex(const std::string& fileName);
+		~EventIndex();
+
+		static bool build(const std::string& fileName,
+		                  const std::vector<std::string>& inFileNames,
+		                  const std::string& treeName,
+		                  const std::string& runBranchName = "Run",
+		                  const std::string& spillBranchName = "SpillNbr",
+		                  const std::string& eventNumberBranchName = "EvNbr");
+
+		bool open();
+
+		// appends the locations of all matching events, a negative spill matches every spill
+		bool find(Int_t run, Int_t spill, Long64_t eventNumber, std::vector<antok::EventIndex::eventLocation>& locations) const;
+
+		ULong64_t getNEvents() const { return _nEvents; }
+		const std::vector<std::string>& getFileNames() const { return _fileNames; }
+
+	  private:
+
+		static const char* __magic;
+		static const unsigned int __version;
+
+		std::string _fileName;
+		std::vector<std::string> _fileNames;
+		ULong64_t _nEvents;
+
+		void* _mapping;
+		size_t _mappingSize;
+		const eventRecord* _records;
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include<external_table.h>
+
+#include<algorithm>
+#include<iostream>
+
+#include<TDirectory.h>
+#include<TFile.h>
+#include<TTree.h>
+
+#include<functions.hpp>
+
+antok::ExternalTable::ExternalTable(const std::string& fileName, unsigned int nColumns, bool sortedMerge)
+	: _fileName(fileName),
+	  _nColumns(nColumns),
+	  _sortedMerge(sortedMerge),
+	  _valid(true),
+	  _file(0),
+	  _tree(0),
+	  _nTreeEntries(0),
+	  _treeEntry(0),
+	  _run(0),
+	  _eventNumber(0),
+	  _values(nColumns, 0.),
+	  _haveRecord(false),
+	  _lastKey(0, 0) { }
+
+antok::ExternalTable::~ExternalTable() {
+
+	if(_file) {
+		_file->Close();
+		delete _file;
+	}
+
+}
+
+bool antok::ExternalTable::openTree(const std::string& treeName,
+                                    const std::string& runBranchName,
+                                    const std::string& eventNumberBranchName,
+                                    const std::vector<std::string>& columnNames)
+{
+
+	if(columnNames.size() != _nColumns) {
+		std::cerr<<"Got "<<columnNames.size()<<" columns for external table \""<<_fileName<<"\", expected "<<_nColumns<<"."<<std::endl;
+		return false;
+	}
+	TDirectory* previousDirectory = gDirectory;
+	_file = TFile::Open(_fileName.c_str(), "READ");
+	previousDirectory->cd();
+	if(_file == 0) {
+		std::cerr<<"Could not open external table \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	_tree = dynamic_cast<TTree*>(_file->Get(treeName.c_str()));
+	if(_tree == 0) {
+		std::cerr<<"Could not find TTree \""<<treeName<<"\" in external table \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	_tree->SetBranchStatus("*", false);
+	std::vector<std::string> branchNames(columnNames);
+	branchNames.push_back(runBranchName);
+	branchNames.push_back(eventNumberBranchName);
+	for(unsigned int i = 0; i < branchNames.size(); ++i) {
+		if(_tree->GetBranch(branchNames[i].c_str()) == 0) {
+			std::cerr<<"Could not find branch \""<<branchNames[i]<<"\" in external table \""<<_fileName<<"\"."<<std::endl;
+			return false;
+		}
+		_tree->SetBranchStatus(branchNames[i].c_str(), true);
+	}
+	if(_tree->SetBranchAddress(runBranchName.c_str(), &_run) < 0 or
+	   _tree->SetBranchAddress(eventNumberBranchName.c_str(), &_eventNumber) < 0)
+	{
+		std::cerr<<"Run number \""<<runBranchName<<"\" has to be an int and event number \""<<eventNumberBranchName<<"\" "
+		         <<"a Long64_t branch in external table \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	for(unsigned int i = 0; i < _nColumns; ++i) {
+		if(_tree->SetBranchAddress(columnNames[i].c_str(), &_values[i]) < 0) {
+			std::cerr<<"Column \""<<columnNames[i]<<"\" of external table \""<<_fileName<<"\" has to be a double branch."<<std::endl;
+			return false;
+		}
+	}
+	_nTreeEntries = _tree->GetEntries();
+	_treeEntry = 0;
+	if(_sortedMerge) {
+		_haveRecord = nextRecord();
+		return true;
+	}
+	return loadAll();
+
+}
+
+bool antok::ExternalTable::openBinary() {
+
+	_binaryFile.open(_fileName.c_str(), std::ios::in | std::ios::binary);
+	if(not _binaryFile.is_open()) {
+		std::cerr<<"Could not open external table \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	if(_sortedMerge) {
+		_haveRecord = nextRecord();
+		return true;
+	}
+	return loadAll();
+
+}
+
+bool antok::ExternalTable::rewind() {
+
+	if(not _sortedMerge) {
+		return true;
+	}
+	if(_tree) {
+		_treeEntry = 0;
+	} else {
+		_binaryFile.clear();
+		_binaryFile.seekg(0);
+		if(not _binaryFile.good()) {
+			std::cerr<<"Could not rewind external table \""<<_fileName<<"\"."<<std::endl;
+			return false;
+		}
+	}
+	_valid = true;
+	_lastKey = eventKey(0, 0);
+	_haveRecord = nextRecord();
+	return true;
+
+}
+
+bool antok::ExternalTable::nextRecord() {
+
+	if(_tree) {
+		if(_treeEntry >= _nTreeEntries) {
+			return false;
+		}
+		return (_tree->GetEntry(_treeEntry++) > 0);
+	}
+	_binaryFile.read((char*)&_run, sizeof(_run));
+	_binaryFile.read((char*)&_eventNumber, sizeof(_eventNumber));
+	_binaryFile.read((char*)&_values[0], _nColumns * sizeof(double));
+	return _binaryFile.good();
+
+}
+
+bool antok::ExternalTable::loadAll() {
+
+	ULong64_t nDuplicates = 0;
+	while(nextRecord()) {
+		if(not _index.insert(std::pair<eventKey, ULong64_t>(eventKey(_run, _eventNumber), _table.size() / _nColumns)).second) {
+			++nDuplicates;
+			continue;
+		}
+		_table.insert(_table.end(), _values.begin(), _values.end());
+	}
+	if(_binaryFile.is_open() and not _binaryFile.eof()) {
+		std::cerr<<"Could not read external table \""<<_fileName<<"\"."<<std::endl;
+		return false;
+	}
+	if(nDuplicates > 0) {
+		std::cerr<<"Warning: "<<nDuplicates<<" events appear more than once in external table \""<<_fileName<<"\", using the first one."<<std::endl;
+	}
+	std::cout<<"Read "<<_index.size()<<" events from external table \""<<_fileName<<"\"."<<std::endl;
+	if(_file) {
+		_file->Close();
+		delete _file;
+		_file = 0;
+		_tree = 0;
+	}
+	_binaryFile.close();
+	return true;
+
+}
+
+bool antok::ExternalTable::lookup(Int_t run, Long64_t eventNumber, double* values) {
+
+	const eventKey key(run, eventNumber);
+	if(not _sortedMerge) {
+		boost::unordered_map<eventKey, ULong64_t>::const_iterator it = _index.find(key);
+		if(it == _index.end()) {
+			return false;
+		}
+		std::copy(_table.begin() + it->second * _nColumns, _table.begin() + (it->second + 1) * _nColumns, values);
+		return true;
+	}
+
+	if(key < _lastKey) {
+		std::cerr<<"Input is not sorted by run and event number (run "<<run<<", event "<<eventNumber<<"), ";
+		std::cerr<<"cannot merge with external table \""<<_fileName<<"\"."<<std::endl;
+		_valid = false;
+		return false;
+	}
+	_lastKey = key;
+	while(_haveRecord and eventKey(_run, _eventNumber) < key) {
+		_haveRecord = nextRecord();
+	}
+	if(not _haveRecord or eventKey(_run, _eventNumber) != key) {
+		return false;
+	}
+	std::copy(_values.begin(), _values.end(), values);
+	return true;
+
+}
+
+antok::functions::JoinExternalTable::~JoinExternalTable() {
+
+	delete _table;
+
+}
+
+bool antok::functions::JoinExternalTable::operator() () {
+
+	if(not _table->lookup(*_runAddr, *_eventNumberAddr, &_values[0])) {
+		if(not _table->isValid()) {
+			return false;
+		}
+		std::fill(_values.begin(), _values.end(), _defaultValue);
+	}
+	for(unsigned int i = 0; i < _outAddrs.size(); ++i) {
+		*(_outAddrs[i]) = _values[i];
+	}
+	return true;
+
+}
+
+bool antok::functions::JoinExternalTable::resetForNextInput() {
+
+	return _table->rewind();
+
+}
@@ -0,0 +1,79 @@
+#ifndef ANTOK_EXTERNAL_TABLE_H
+#define ANTOK_EXTERNAL_TABLE_H
+
+#include<fstream>
+#include<string>
+#include<utility>
+#include<vector>
+
+#include<boost/unordered_map.hpp>
+
+#include<Rtypes.h>
+
+class TFile;
+class TTree;
+
+namespace antok {
+
+	// Per-event columns of doubles from a file in another entry order, found
+	// by (run, event number). The table is either a TTree or a flat binary
+	// file of records (Int_t run, Long64_t event number, one double per
+	// column). By default it is read completely into a hash map; in sorted
+	// merge mode the table and the input have to be sorted by run and event
+	// number, and the table is read alongside the input instead.
+	class ExternalTable {
+
+	  public:
+
+		ExternalTable(const std::string& fileName, unsigned int nColumns, bool sortedMerge);
+		~ExternalTable();
+
+		bool openTree(const std::string& treeName,
+		              const std::string& runBranchName,
+		              const std::string& eventNumberBranchName,
+		              const std::vector<std::string>& columnNames);
+		bool openBinary();
+
+		// copies the columns of the matching record to values, false if there is none
+		bool lookup(Int_t run, Long64_t eventNumber, double* values);
+
+		// false if the input turned out not to be sorted in sorted merge mode
+		bool isValid() const { return _valid; }
+
+		// starts the sorted merge from the beginning for the next input file
+		bool rewind();
+
+	  private:
+
+		typedef std::pair<Int_t, Long64_t> eventKey;
+
+		bool nextRecord();
+		bool loadAll();
+
+		std::string _fileName;
+		unsigned int _nColumns;
+		bool _sortedMerge;
+		bool _valid;
+
+		TFile* _file;
+		TTree* _tree;
+		Long64_t _nTreeEntries;
+		Long64_t _treeEntry;
+		std::ifstream _binaryFile;
+
+		// the record read last
+		Int_t _run;
+		Long64_t _eventNumber;
+		std::vector<double> _values;
+		bool _haveRecord;
+		eventKey _lastKey;
+
+		// hash mode, the columns of record i start at _table[i * _nColumns]
+		boost::unordered_map<eventKey, ULong64_t> _index;
+		std::vector<double> _table;
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef ANTOK_FLAT_EVENT_FILE_HPP
+#define ANTOK_FLAT_EVENT_FILE_HPP
+
+#include<cstring>
+#include<fcntl.h>
+#include<iostream>
+#include<stdint.h>
+#include<string>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+// Flat binary event file written by root_to_root for one mass bin, to be
+// memory mapped by a fitter without any deserialization. Does not need ROOT.
+//
+// Layout: a 64 byte header followed by one array of nEvents doubles per
+// particle and component (px, py, pz, E), every array starting at a
+// multiple of 64 bytes. The production particles come first, then the
+// decay particles, in the order of the prodKinParticles and
+// decayKinParticles of the ROOT files.
+
+namespace antok {
+
+	struct flatEventFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t nProdParticles;
+		uint32_t nDecayParticles;
+		uint32_t alignment;
+		uint64_t nEvents;
+		double massLow;
+		double massHigh;
+		// bytes from the start of the file to the first array and between two arrays
+		uint64_t dataOffset;
+		uint64_t arrayStride;
+	};
+
+	class FlatEventFile {
+
+	  public:
+
+		static const char* magic() { return "ANTOKFLT"; }
+		static uint32_t version() { return 1; }
+		static uint32_t alignment() { return 64; }
+		static uint32_t nComponents() { return 4; }
+
+		static uint64_t arrayStride(uint64_t nEvents) {
+			const uint64_t bytes = nEvents * sizeof(double);
+			return ((bytes + alignment() - 1) / alignment()) * alignment();
+		}
+
+		FlatEventFile(const std::string& fileName)
+			: _fileName(fileName),
+			  _mapping(0),
+			  _mappingSize(0),
+			  _header(0) { }
+
+		~FlatEventFile() {
+			if(_mapping) {
+				munmap(_mapping, _mappingSize);
+			}
+		}
+
+		bool open() {
+			const int descriptor = ::open(_fileName.c_str(), O_RDONLY);
+			if(descriptor < 0) {
+				std::cerr<<"Could not open flat event file \""<<_fileName<<"\"."<<std::endl;
+				return false;
+			}
+			struct stat fileStatus;
+			if(fstat(descriptor, &fileStatus) != 0 or (size_t)fileStatus.st_size < sizeof(flatEventFileHeader)) {
+				std::cerr<<"Flat event file \""<<_fileName<<"\" is corrupt."<<std::endl;
+				close(descriptor);
+				return false;
+			}
+			_mappingSize = fileStatus.st_size;
+			_mapping = mmap(0, _mappingSize, PROT_READ, MAP_SHARED, descriptor, 0);
+			close(descriptor);
+			if(_mapping == MAP_FAILED) {
+				std::cerr<<"Could not map flat event file \""<<_fileName<<"\"."<<std::endl;
+				_mapping = 0;
+				return false;
+			}
+			const flatEventFileHeader* header = (const flatEventFileHeader*)_mapping;
+			const uint64_t nArrays = (uint64_t)(header->nProdParticles + header->nDecayParticles) * nComponents();
+			if(std::strncmp(header->magic, magic(), 8) != 0 or header->version != version() or
+			   header->arrayStride != arrayStride(header->nEvents) or
+			   header->dataOffset + nArrays * header->arrayStride != _mappingSize)
+			{
+				std::cerr<<"Flat event file \""<<_fileName<<"\" is corrupt or of another version."<<std::endl;
+				return false;
+			}
+			_header = header;
+			return true;
+		}
+
+		uint64_t getNEvents() const { return _header->nEvents; }
+		unsigned int getNProdParticles() const { return _header->nProdParticles; }
+		unsigned int getNDecayParticles() const { return _header->nDecayParticles; }
+		double getMassLow() const { return _header->massLow; }
+		double getMassHigh() const { return _header->massHigh; }
+
+		// component 0, 1, 2, 3 is px, py, pz, E, the array holds all events
+		const double* getProdMomenta(unsigned int particle, unsigned int component) const {
+			return getArray(particle * nComponents() + component);
+		}
+		const double* getDecayMomenta(unsigned int particle, unsigned int component) const {
+			return getArray((_header->nProdParticles + particle) * nComponents() + component);
+		}
+
+	  private:
+
+		FlatEventFile(const FlatEventFile&);
+		FlatEventFile& operator=(const FlatEventFile&);
+
+		const double* getArray(uint64_t array_i) const {
+			return (const double*)((const char*)_mapping + _header->dataOffset + array_i * _header->arrayStride);
+		}
+
+		std::string _fileName;
+		void* _mapping;
+		size_t _mappingSize;
+		const flatEventFileHeader* _header;
+
+	};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef ANTOK_FUNCTIONS_HPP
 #define ANTOK_FUNCTIONS_HPP
 
+#include<algorithm>
 #include<iostream>
 #include<vector>
 
@@ -10,6 +11,8 @@
 
 namespace antok {
 
+	class ExternalTable;
+
 	class Function
 	{
 
@@ -17,6 +20,8 @@ namespace antok {
 
 		virtual bool operator() () = 0;
 		virtual ~Function() { }
+		// called when the input file is switched, for functions which follow the input order
+		virtual bool resetForNextInput() { return true; }
 
 	};
 
@@ -433,6 +438,37 @@ namespace antok {
 
 		};
 
+		class JoinExternalTable : public Function
+		{
+
+		  public:
+
+			JoinExternalTable(int* runAddr, Long64_t* eventNumberAddr, antok::ExternalTable* table, std::vector<double*> outAddrs, double defaultValue)
+				: _runAddr(runAddr),
+				  _eventNumberAddr(eventNumberAddr),
+				  _table(table),
+				  _outAddrs(outAddrs),
+				  _defaultValue(defaultValue),
+				  _values(outAddrs.size(), 0.) { }
+
+			// defined in external_table.cxx, so that the table's dependencies stay out of this header
+			virtual ~JoinExternalTable();
+
+			bool operator() ();
+
+			bool resetForNextInput();
+
+		  private:
+
+			int* _runAddr;
+			Long64_t* _eventNumberAddr;
+			antok::ExternalTable* _table;
+			std::vector<double*> _outAddrs;
+			double _defaultValue;
+			std::vector<double> _values;
+
+		};
+
 	}
 
 }
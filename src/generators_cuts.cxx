@@ -3,6 +3,7 @@
 #include<iostream>
 
 #include<TLorentzVector.h>
+#include<TVector3.h>
 
 #include<cut.hpp>
 #include<data.h>
@@ -41,6 +42,29 @@ namespace {
 
 	}
 
+	template<typename T>
+	antok::Cut* __getTriggerMaskCut(const YAML::Node& cut,
+	                                const std::string& shortName,
+	                                const std::string& longName,
+	                                const std::string& abbreviation,
+	                                bool* const result,
+	                                int mode)
+	{
+
+		T* maskAddr = antok::YAMLUtils::getAddress<T>(cut["Mask"]);
+		if(maskAddr == 0) {
+			std::cerr<<"\"Mask\" entry invalid in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+			return 0;
+		}
+		T* variable = antok::YAMLUtils::getAddress<T>(cut["Variable"]);
+		if(variable == 0) {
+			std::cerr<<"\"Variable\" entry invalid in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+			return 0;
+		}
+		return (new antok::cuts::TriggerMaskCut<T>(shortName, longName, abbreviation, result, maskAddr, variable, mode));
+
+	}
+
 	antok::Cut* __getEllipticCut(const YAML::Node& cut,
 	                             const std::string& shortName,
 	                             const std::string& longName,
@@ -86,39 +110,41 @@ namespace {
 
 	}
 
-	antok::Cut* __generateRangeCut(const YAML::Node& cut,
-	                               const std::string& shortName,
-	                               const std::string& longName,
-	                               const std::string& abbreviation,
-	                               bool* const result)
+	template<typename T>
+	antok::Cut* __getRangeCut(const YAML::Node& cut,
+	                          const std::string& shortName,
+	                          const std::string& longName,
+	                          const std::string& abbreviation,
+	                          bool* const result,
+	                          T* variable,
+	                          const std::string& typeName)
 	{
 
 		using antok::YAMLUtils::hasNodeKey;
 
-		if(not (hasNodeKey(cut, "Type") and hasNodeKey(cut, "Variable"))) {
-			std::cerr<<"A required entry is missing for \"Range\" cut \""<<shortName<<"\" (either \"Type\" or \"Variable\")"<<std::endl;
-			return 0;
-		}
 		int method = -1;
-		double* lowerBound = 0;
-		double* upperBound = 0;
+		T* lowerBound = 0;
+		T* upperBound = 0;
 		if(hasNodeKey(cut, "LowerBound") and hasNodeKey(cut, "UpperBound")) {
-			lowerBound = antok::YAMLUtils::getAddress<double>(cut["LowerBound"]);
-			upperBound = antok::YAMLUtils::getAddress<double>(cut["UpperBound"]);
+			lowerBound = antok::YAMLUtils::getAddress<T>(cut["LowerBound"]);
+			upperBound = antok::YAMLUtils::getAddress<T>(cut["UpperBound"]);
 			if(lowerBound == 0 or upperBound == 0) {
-				std::cerr<<"Entries \"LowerBound\"/\"UpperBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type double."<<std::endl;
+				std::cerr<<"Entries \"LowerBound\"/\"UpperBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type "<<typeName<<"."<<std::endl;
+				return 0;
 			}
 			method = 0;
 		} else if(hasNodeKey(cut, "LowerBound")) {
-			lowerBound = antok::YAMLUtils::getAddress<double>(cut["LowerBound"]);
+			lowerBound = antok::YAMLUtils::getAddress<T>(cut["LowerBound"]);
 			if(lowerBound == 0) {
-				std::cerr<<"Entry \"LowerBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type double."<<std::endl;
+				std::cerr<<"Entry \"LowerBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type "<<typeName<<"."<<std::endl;
+				return 0;
 			}
 			method = 4;
 		} else if(hasNodeKey(cut, "UpperBound")) {
-			upperBound = antok::YAMLUtils::getAddress<double>(cut["UpperBound"]);
+			upperBound = antok::YAMLUtils::getAddress<T>(cut["UpperBound"]);
 			if(upperBound == 0) {
-				std::cerr<<"Entries \"LowerBound\"/\"UpperBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type double."<<std::endl;
+				std::cerr<<"Entry \"UpperBound\" invalid in \"Range\" cut \""<<shortName<<"\", has to be either a variable name or of type "<<typeName<<"."<<std::endl;
+				return 0;
 			}
 			method = 2;
 		} else {
@@ -137,18 +163,42 @@ namespace {
 			std::cerr<<"\"Type\" entry in \"Range\" cut \""<<shortName<<"\" has either to be \"Exclusive\" or \"Inclusive\""<<std::endl;
 			return 0;
 		}
+		return (new antok::cuts::RangeCut<T>(shortName, longName, abbreviation, result, lowerBound, upperBound, variable, method));
+
+	}
+
+	antok::Cut* __generateRangeCut(const YAML::Node& cut,
+	                               const std::string& shortName,
+	                               const std::string& longName,
+	                               const std::string& abbreviation,
+	                               bool* const result)
+	{
+
+		using antok::YAMLUtils::hasNodeKey;
+
+		if(not (hasNodeKey(cut, "Type") and hasNodeKey(cut, "Variable"))) {
+			std::cerr<<"A required entry is missing for \"Range\" cut \""<<shortName<<"\" (either \"Type\" or \"Variable\")"<<std::endl;
+			return 0;
+		}
 		std::string varName = antok::YAMLUtils::getString(cut["Variable"]);
 		if(varName == "") {
 			std::cerr<<"Could not convert \"Range\" cut \""<<shortName<<"\"'s \"Variable\" entry to std::string."<<std::endl;
 			return 0;
 		}
 		antok::Data& data = antok::ObjectManager::instance()->getData();
-		double* variable = data.getAddr<double>(varName);
-		if(variable == 0) {
+		std::string typeName = data.getType(varName);
+		if(typeName == "double") {
+			return __getRangeCut<double>(cut, shortName, longName, abbreviation, result, data.getAddr<double>(varName), typeName);
+		} else if(typeName == "int") {
+			return __getRangeCut<int>(cut, shortName, longName, abbreviation, result, data.getAddr<int>(varName), typeName);
+		} else if(typeName == "Long64_t") {
+			return __getRangeCut<Long64_t>(cut, shortName, longName, abbreviation, result, data.getAddr<Long64_t>(varName), typeName);
+		} else if(typeName == "") {
 			std::cerr<<"Could not find \"Range\" cut \""<<shortName<<"\"'s \"Variable\" entry \""<<varName<<"\" in Data."<<std::endl;
 			return 0;
 		}
-		return (new antok::cuts::RangeCut(shortName, longName, abbreviation, result, lowerBound, upperBound, variable, method));
+		std::cerr<<"Type \""<<typeName<<"\" not supported in \"Range\" cut \""<<shortName<<"\"."<<std::endl;
+		return 0;
 
 	};
 
@@ -198,8 +248,12 @@ namespace {
 			antokCut = __getEqualityCut<int>(cut, shortName, longName, abbreviation, result, mode);
 		} else if (typeName == "Long64_t") {
 			antokCut = __getEqualityCut<Long64_t>(cut, shortName, longName, abbreviation, result, mode);
+		} else if (typeName == "std::vector<double>") {
+			antokCut = __getEqualityCut<std::vector<double> >(cut, shortName, longName, abbreviation, result, mode);
 		} else if (typeName == "TLorentzVector") {
 			antokCut = __getEqualityCut<TLorentzVector>(cut, shortName, longName, abbreviation, result, mode);
+		} else if (typeName == "TVector3") {
+			antokCut = __getEqualityCut<TVector3>(cut, shortName, longName, abbreviation, result, mode);
 		} else {
 			std::cerr<<"Type \""<<typeName<<"\" not supported in \"Equality\" cut \""<<shortName<<"\"."<<std::endl;
 			return 0;
@@ -293,19 +347,110 @@ namespace {
 			return 0;
 		}
 
-		int* maskAddr = antok::YAMLUtils::getAddress<int>(cut["Mask"]);
-		if(maskAddr == 0) {
-			std::cerr<<"\"Mask\" entry invalid in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+		std::string variableName = antok::YAMLUtils::getString(cut["Variable"]);
+		antok::Data& data = antok::ObjectManager::instance()->getData();
+		std::string typeName = data.getType(variableName);
+		if(typeName == "int") {
+			return __getTriggerMaskCut<int>(cut, shortName, longName, abbreviation, result, mode);
+		} else if(typeName == "Long64_t") {
+			return __getTriggerMaskCut<Long64_t>(cut, shortName, longName, abbreviation, result, mode);
+		} else if(typeName == "") {
+			std::cerr<<"\"Variable\" entry invalid in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+			return 0;
+		}
+		std::cerr<<"Type \""<<typeName<<"\" not supported in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+		return 0;
+
+	};
+
+	antok::Cut* __generateVectorRangeCut(const YAML::Node& cut,
+	                                     const std::string& shortName,
+	                                     const std::string& longName,
+	                                     const std::string& abbreviation,
+	                                     bool* const result)
+	{
+
+		using antok::YAMLUtils::hasNodeKey;
+
+		if(not (hasNodeKey(cut, "Type") and hasNodeKey(cut, "Quantifier") and hasNodeKey(cut, "Variable"))) {
+			std::cerr<<"One of the required arguments (\"Type\", \"Quantifier\" and \"Variable\") for \"VectorRange\" cut \""<<shortName<<"\" is missing."<<std::endl;
+			return 0;
+		}
+
+		std::string type = antok::YAMLUtils::getString(cut["Type"]);
+		bool inclusive = false;
+		if(type == "Inclusive") {
+			inclusive = true;
+		} else if(type != "Exclusive") {
+			std::cerr<<"\"Type\" entry in \"VectorRange\" cut \""<<shortName<<"\" has either to be \"Exclusive\" or \"Inclusive\""<<std::endl;
+			return 0;
+		}
+
+		std::string quantifierName = antok::YAMLUtils::getString(cut["Quantifier"]);
+		int quantifier = -1;
+		if(quantifierName == "Any") {
+			quantifier = 0;
+		} else if(quantifierName == "All") {
+			quantifier = 1;
+		} else if(quantifierName == "Count") {
+			quantifier = 2;
+		} else {
+			std::cerr<<"\"Quantifier\" entry in \"VectorRange\" cut \""<<shortName<<"\" has to be \"Any\", \"All\" or \"Count\"."<<std::endl;
 			return 0;
 		}
 
-		int* variable = antok::YAMLUtils::getAddress<int>(cut["Variable"]);
+		if(not (hasNodeKey(cut, "LowerBound") or hasNodeKey(cut, "UpperBound"))) {
+			std::cerr<<"Either \"LowerBound\" or \"UpperBound\" has to be present in \"VectorRange\" cut \""<<shortName<<"\"."<<std::endl;
+			return 0;
+		}
+		double* lowerBound = 0;
+		if(hasNodeKey(cut, "LowerBound")) {
+			lowerBound = antok::YAMLUtils::getAddress<double>(cut["LowerBound"]);
+			if(lowerBound == 0) {
+				std::cerr<<"Entry \"LowerBound\" invalid in \"VectorRange\" cut \""<<shortName<<"\", has to be either a variable name or of type double."<<std::endl;
+				return 0;
+			}
+		}
+		double* upperBound = 0;
+		if(hasNodeKey(cut, "UpperBound")) {
+			upperBound = antok::YAMLUtils::getAddress<double>(cut["UpperBound"]);
+			if(upperBound == 0) {
+				std::cerr<<"Entry \"UpperBound\" invalid in \"VectorRange\" cut \""<<shortName<<"\", has to be either a variable name or of type double."<<std::endl;
+				return 0;
+			}
+		}
+
+		int* minCount = 0;
+		int* maxCount = 0;
+		if(quantifier == 2) {
+			if(not hasNodeKey(cut, "MinCount")) {
+				std::cerr<<"\"Count\" quantifier needs a \"MinCount\" entry in \"VectorRange\" cut \""<<shortName<<"\"."<<std::endl;
+				return 0;
+			}
+			minCount = antok::YAMLUtils::getAddress<int>(cut["MinCount"]);
+			if(minCount == 0) {
+				std::cerr<<"Entry \"MinCount\" invalid in \"VectorRange\" cut \""<<shortName<<"\", has to be either a variable name or of type int."<<std::endl;
+				return 0;
+			}
+			if(hasNodeKey(cut, "MaxCount")) {
+				maxCount = antok::YAMLUtils::getAddress<int>(cut["MaxCount"]);
+				if(maxCount == 0) {
+					std::cerr<<"Entry \"MaxCount\" invalid in \"VectorRange\" cut \""<<shortName<<"\", has to be either a variable name or of type int."<<std::endl;
+					return 0;
+				}
+			}
+		}
+
+		std::string varName = antok::YAMLUtils::getString(cut["Variable"]);
+		antok::Data& data = antok::ObjectManager::instance()->getData();
+		std::vector<double>* variable = data.getAddr<std::vector<double> >(varName);
 		if(variable == 0) {
-			std::cerr<<"\"Variable\" entry invalid in \"TriggerMask\" cut \""<<shortName<<"\"."<<std::endl;
+			std::cerr<<"Could not find \"VectorRange\" cut \""<<shortName<<"\"'s \"Variable\" entry \""<<varName<<"\" of type std::vector<double> in Data."<<std::endl;
 			return 0;
 		}
 
-		return (new antok::cuts::TriggerMaskCut(shortName, longName, abbreviation, result, maskAddr, variable, mode));
+		return (new antok::cuts::VectorRangeCut(shortName, longName, abbreviation, result, lowerBound, upperBound,
+		                                        variable, inclusive, quantifier, minCount, maxCount));
 
 	};
 
@@ -419,6 +564,8 @@ namespace {
 			antokCut = __generateEllipticCut(cut, shortName, longName, abbreviation, result);
 		} else if (cutName == "TriggerMask") {
 			antokCut = __generateTriggerMaskCut(cut, shortName, longName, abbreviation, result);
+		} else if (cutName == "VectorRange") {
+			antokCut = __generateVectorRangeCut(cut, shortName, longName, abbreviation, result);
 		} else if (cutName == "Group") {
 			antokCut = __generateGroupCut(cut, shortName, longName, abbreviation, result);
 		} else if (cutName == "NoCut") {
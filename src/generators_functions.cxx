@@ -5,6 +5,7 @@
 #include<TLorentzVector.h>
 
 #include<data.h>
+#include<external_table.h>
 #include<functions.hpp>
 #include<initializer.h>
 #include<object_manager.h>
@@ -592,6 +593,103 @@ antok::Function* antok::generators::generateGetVector3(const YAML::Node& functio
 
 }
 
+antok::Function* antok::generators::generateJoinExternalTable(const YAML::Node& function, std::vector<std::string>& quantityNames, int index)
+{
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	std::vector<std::pair<std::string, std::string> > args;
+	args.push_back(std::pair<std::string, std::string>("Run", "int"));
+	args.push_back(std::pair<std::string, std::string>("EventNumber", "Long64_t"));
+
+	if(not antok::generators::functionArgumentHandler(args, function, index)) {
+		std::cerr<<antok::generators::getFunctionArgumentHandlerErrorMsg(quantityNames);
+		return 0;
+	}
+
+	std::string fileName = antok::YAMLUtils::getString(function["File"]);
+	if(fileName == "") {
+		std::cerr<<"\"File\" missing or invalid for function \""<<function["Name"]<<"\"."<<std::endl;
+		return 0;
+	}
+	bool sortedMerge = false;
+	if(hasNodeKey(function, "SortedMerge")) {
+		std::string sortedMergeOption = antok::YAMLUtils::getString(function["SortedMerge"]);
+		if(sortedMergeOption == "On") {
+			sortedMerge = true;
+		} else if(sortedMergeOption != "Off") {
+			std::cerr<<"Entry \"SortedMerge\" of function \""<<function["Name"]<<"\" has to be either \"On\" or \"Off\"."<<std::endl;
+			return 0;
+		}
+	}
+	double defaultValue = 0.;
+	if(hasNodeKey(function, "Default")) {
+		try {
+			defaultValue = function["Default"].as<double>();
+		} catch (const YAML::TypedBadConversion<double>& e) {
+			std::cerr<<"Could not convert \"Default\" of function \""<<function["Name"]<<"\" to double."<<std::endl;
+			return 0;
+		}
+	}
+
+	antok::ExternalTable* table = new antok::ExternalTable(fileName, quantityNames.size(), sortedMerge);
+	bool opened = false;
+	if(hasNodeKey(function, "Tree")) {
+		// the columns are named like the quantities unless given
+		std::vector<std::string> columnNames = quantityNames;
+		if(hasNodeKey(function, "Columns")) {
+			try {
+				columnNames = function["Columns"].as<std::vector<std::string> >();
+			} catch (const YAML::TypedBadConversion<std::vector<std::string> >& e) {
+				std::cerr<<"Could not convert \"Columns\" of function \""<<function["Name"]<<"\" to std::vector<std::string>."<<std::endl;
+				delete table;
+				return 0;
+			}
+		}
+		// the run and event number branches are named like the input variables unless given
+		std::string runColumn = antok::YAMLUtils::getString(function["Run"]);
+		std::string eventNumberColumn = antok::YAMLUtils::getString(function["EventNumber"]);
+		if(hasNodeKey(function, "RunColumn")) {
+			runColumn = antok::YAMLUtils::getString(function["RunColumn"]);
+		}
+		if(hasNodeKey(function, "EventNumberColumn")) {
+			eventNumberColumn = antok::YAMLUtils::getString(function["EventNumberColumn"]);
+		}
+		if(runColumn == "" or eventNumberColumn == "") {
+			std::cerr<<"Could not convert \"RunColumn\" or \"EventNumberColumn\" of function \""<<function["Name"]<<"\" to std::string."<<std::endl;
+			delete table;
+			return 0;
+		}
+		opened = table->openTree(antok::YAMLUtils::getString(function["Tree"]), runColumn, eventNumberColumn, columnNames);
+	} else {
+		opened = table->openBinary();
+	}
+	if(not opened) {
+		std::cerr<<antok::generators::getFunctionArgumentHandlerErrorMsg(quantityNames);
+		delete table;
+		return 0;
+	}
+
+	antok::Data& data = antok::ObjectManager::instance()->getData();
+
+	std::vector<double*> quantityAddrs;
+	for(unsigned int i = 0; i < quantityNames.size(); ++i) {
+		if(not data.insert<double>(quantityNames[i])) {
+			std::cerr<<antok::Data::getVariableInsertionErrorMsg(quantityNames, quantityNames[i]);
+			delete table;
+			return 0;
+		}
+		quantityAddrs.push_back(data.getAddr<double>(quantityNames[i]));
+	}
+
+	return (new antok::functions::JoinExternalTable(data.getAddr<int>(args[0].first),
+	                                                 data.getAddr<Long64_t>(args[1].first),
+	                                                 table,
+	                                                 quantityAddrs,
+	                                                 defaultValue));
+
+};
+
 antok::Function* antok::generators::generateMass(const YAML::Node& function, std::vector<std::string>& quantityNames, int index)
 {
 
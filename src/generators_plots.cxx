@@ -2,10 +2,14 @@
 
 #include<TH1D.h>
 #include<TH2D.h>
+#include<TAxis.h>
+#include<THnSparse.h>
 
 #include<cutter.h>
 #include<object_manager.h>
 #include<plotter.h>
+#include<sparse_plot.h>
+#include<summary_plot.h>
 #include<template_plot.hpp>
 #include<yaml_utils.hpp>
 
@@ -411,3 +415,129 @@ antok::Plot* antok::generators::generate2DPlot(const YAML::Node& plot, const ant
 
 }
 
+
+antok::Plot* antok::generators::generateNDimPlot(const YAML::Node& plot, const antok::plotUtils::GlobalPlotOptions& plotOptions) {
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	std::string plotName = antok::YAMLUtils::getString(plot["Name"]);
+	if(hasNodeKey(plot, "Indices")) {
+		std::cerr<<"\"Indices\" are not supported for \"Plot\" \""<<plotName<<"\" with more than 2 \"Variables\"."<<std::endl;
+		return 0;
+	}
+	const unsigned int nDim = plot["Variables"].size();
+	if(hasNodeKey(plot, "AxisLabels") and (not plot["AxisLabels"].IsSequence() or plot["AxisLabels"].size() != nDim)) {
+		std::cerr<<"\"AxisLabels\" need to be a sequence with one entry per \"Variables\" entry (in \"Plot\" \""<<plotName<<"\")."<<std::endl;
+		return 0;
+	}
+
+	antok::Data& data = ObjectManager::instance()->getData();
+	std::vector<int> nBins(nDim, 0);
+	std::vector<double> lowerBounds(nDim, 0.);
+	std::vector<double> upperBounds(nDim, 0.);
+	std::vector<std::string> axisLabels(nDim, "");
+	std::vector<const double*> doubleVariables(nDim, 0);
+	std::vector<const int*> intVariables(nDim, 0);
+	for(unsigned int i = 0; i < nDim; ++i) {
+		if(not antok::YAMLUtils::getValue<double>(plot["LowerBounds"][i], &lowerBounds[i])) {
+			std::cerr<<"Could not get entry "<<i<<" of the \"LowerBounds\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		if(not antok::YAMLUtils::getValue<double>(plot["UpperBounds"][i], &upperBounds[i])) {
+			std::cerr<<"Could not get entry "<<i<<" of the \"UpperBounds\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		if(lowerBounds[i] >= upperBounds[i]) {
+			std::cerr<<"Entry "<<i<<" of the \"LowerBounds\" >= \"UpperBounds\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		if(not antok::YAMLUtils::getValue<int>(plot["NBins"][i], &nBins[i])) {
+			std::cerr<<"Could not get entry "<<i<<" of the \"NBins\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		std::string variableName = antok::YAMLUtils::getString(plot["Variables"][i]);
+		if(variableName == "") {
+			std::cerr<<"Entry "<<i<<" of the \"Variables\" invalid for \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		axisLabels[i] = variableName;
+		if(hasNodeKey(plot, "AxisLabels") and not antok::YAMLUtils::getValue<std::string>(plot["AxisLabels"][i], &axisLabels[i])) {
+			std::cerr<<"Could not get entry "<<i<<" of the \"AxisLabels\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		}
+		std::string variableType = data.getType(variableName);
+		if(variableType == "double") {
+			doubleVariables[i] = data.getAddr<double>(variableName);
+		} else if(variableType == "int") {
+			intVariables[i] = data.getAddr<int>(variableName);
+		} else if(variableType == "") {
+			std::cerr<<"Could not find \"Variable\" \""<<variableName<<"\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+			return 0;
+		} else {
+			std::cerr<<"\"Variable\"'s type \""<<variableType<<"\" not supported by \"Plot\" with more than 2 \"Variables\" (in \""<<plotName<<"\")."<<std::endl;
+			return 0;
+		}
+	}
+
+	std::map<std::string, std::vector<long> > cutmasks;
+	if(hasNodeKey(plot, "CustomCuts")) {
+		if(not antok::Plotter::handleAdditionalCuts(plot["CustomCuts"], cutmasks)) {
+			std::cerr<<"Warning: There was a problem when processing the \"CustomCuts\" in \"Plot\" \""<<plotName<<"\"."<<std::endl;
+		}
+	}
+	__getCutmasks(plotOptions, cutmasks);
+
+	THnSparse* histTemplate = new THnSparseD(plotName.c_str(), plotName.c_str(), nDim, &nBins[0], &lowerBounds[0], &upperBounds[0]);
+	for(unsigned int i = 0; i < nDim; ++i) {
+		histTemplate->GetAxis(i)->SetTitle(axisLabels[i].c_str());
+	}
+	histTemplate->Sumw2();
+
+	return new antok::SparsePlot(cutmasks, histTemplate, doubleVariables, intVariables);
+
+}
+
+antok::SummaryPlot* antok::generators::generateSummary(const YAML::Node& summary,
+                                                       const antok::plotUtils::GlobalPlotOptions& plotOptions,
+                                                       unsigned int sketchSize,
+                                                       const std::vector<double>& quantileLevels)
+{
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	std::string variableName = antok::YAMLUtils::getString(summary["Variable"]);
+	if(variableName == "") {
+		std::cerr<<"\"Variable\" entry missing or invalid for one of the \"Summaries\"."<<std::endl;
+		return 0;
+	}
+
+	antok::Data& data = ObjectManager::instance()->getData();
+	const double* doubleVariable = 0;
+	const int* intVariable = 0;
+	const std::vector<double>* vectorVariable = 0;
+	std::string variableType = data.getType(variableName);
+	if(variableType == "double") {
+		doubleVariable = data.getAddr<double>(variableName);
+	} else if(variableType == "int") {
+		intVariable = data.getAddr<int>(variableName);
+	} else if(variableType == "std::vector<double>") {
+		vectorVariable = data.getAddr<std::vector<double> >(variableName);
+	} else if(variableType == "") {
+		std::cerr<<"Could not find \"Variable\" \""<<variableName<<"\" of the \"Summaries\"."<<std::endl;
+		return 0;
+	} else {
+		std::cerr<<"\"Variable\"'s type \""<<variableType<<"\" not supported by \"Summaries\" (in \""<<variableName<<"\")."<<std::endl;
+		return 0;
+	}
+
+	std::map<std::string, std::vector<long> > cutmasks;
+	if(hasNodeKey(summary, "CustomCuts")) {
+		if(not antok::Plotter::handleAdditionalCuts(summary["CustomCuts"], cutmasks)) {
+			std::cerr<<"Warning: There was a problem when processing the \"CustomCuts\" in the \"Summaries\" of \""<<variableName<<"\"."<<std::endl;
+		}
+	}
+	__getCutmasks(plotOptions, cutmasks);
+
+	return new antok::SummaryPlot(cutmasks, variableName, doubleVariable, intVariable, vectorVariable, sketchSize, quantileLevels);
+
+}
@@ -1,11 +1,14 @@
 #ifndef ANTOK_GENERATORS_PLOTS_H
 #define ANTOK_GENERATORS_PLOTS_H
 
+#include<vector>
+
 #include<yaml-cpp/yaml.h>
 
 namespace antok {
 
 	class Plot;
+	class SummaryPlot;
 
 	namespace plotUtils {
 
@@ -21,6 +24,14 @@ namespace antok {
 		antok::Plot* generate2DPlot(const YAML::Node& plot,
 		                            const antok::plotUtils::GlobalPlotOptions& plotOptions);
 
+		antok::Plot* generateNDimPlot(const YAML::Node& plot,
+		                              const antok::plotUtils::GlobalPlotOptions& plotOptions);
+
+		antok::SummaryPlot* generateSummary(const YAML::Node& summary,
+		                                    const antok::plotUtils::GlobalPlotOptions& plotOptions,
+		                                    unsigned int sketchSize,
+		                                    const std::vector<double>& quantileLevels);
+
 	}
 
 }
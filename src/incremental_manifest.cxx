@@ -0,0 +1,105 @@
+#include<incremental_manifest.h>
+
+#include<iostream>
+#include<sstream>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include<TFile.h>
+#include<TObjString.h>
+
+antok::IncrementalManifest::IncrementalManifest(ULong64_t configHash)
+	: _configHash(configHash) { }
+
+bool antok::IncrementalManifest::read(const std::string& outFileName) {
+
+	_files.clear();
+	if(access(outFileName.c_str(), F_OK) != 0) {
+		return false;
+	}
+	TFile* outFile = TFile::Open(outFileName.c_str(), "READ");
+	if(outFile == 0 or outFile->IsZombie()) {
+		std::cerr<<"Could not open the cumulative output \""<<outFileName<<"\"."<<std::endl;
+		delete outFile;
+		return false;
+	}
+	TObjString* text = dynamic_cast<TObjString*>(outFile->Get(objectName()));
+	std::stringstream manifest(text ? text->GetName() : "");
+	delete outFile;
+	if(text == 0) {
+		std::cerr<<"The cumulative output \""<<outFileName<<"\" has no manifest."<<std::endl;
+		return false;
+	}
+	std::string configHash;
+	if(not (manifest>>configHash)) {
+		std::cerr<<"Could not read the config hash from the manifest of \""<<outFileName<<"\"."<<std::endl;
+		return false;
+	}
+	std::stringstream strStr;
+	strStr<<std::hex<<_configHash;
+	if(configHash != strStr.str()) {
+		return false;
+	}
+	inputFile file;
+	while(manifest>>file.path>>file.size>>file.modificationTime) {
+		_files.push_back(file);
+	}
+	if(not manifest.eof()) {
+		std::cerr<<"Could not read the manifest of \""<<outFileName<<"\"."<<std::endl;
+		_files.clear();
+		return false;
+	}
+	return true;
+
+}
+
+bool antok::IncrementalManifest::write(TFile* outFile) const {
+
+	std::stringstream manifest;
+	manifest<<std::hex<<_configHash<<std::dec<<std::endl;
+	for(unsigned int i = 0; i < _files.size(); ++i) {
+		const inputFile& file = _files[i];
+		manifest<<file.path<<" "<<file.size<<" "<<file.modificationTime<<std::endl;
+	}
+	TDirectory* directory = gDirectory;
+	outFile->cd();
+	// the merger copies the manifest of the old output
+	outFile->Delete((std::string(objectName()) + ";*").c_str());
+	TObjString text(manifest.str().c_str());
+	const bool success = (text.Write(objectName()) > 0);
+	directory->cd();
+	if(not success) {
+		std::cerr<<"Could not write the manifest to \""<<outFile->GetName()<<"\"."<<std::endl;
+	}
+	return success;
+
+}
+
+bool antok::IncrementalManifest::getInputFile(const std::string& path, inputFile& file) {
+
+	struct stat fileStatus;
+	if(stat(path.c_str(), &fileStatus) != 0) {
+		std::cerr<<"Could not find input file \""<<path<<"\"."<<std::endl;
+		return false;
+	}
+	file.path = path;
+	file.size = fileStatus.st_size;
+	file.modificationTime = fileStatus.st_mtime;
+	return true;
+
+}
+
+int antok::IncrementalManifest::getState(const inputFile& file) const {
+
+	for(unsigned int i = 0; i < _files.size(); ++i) {
+		if(_files[i].path != file.path) {
+			continue;
+		}
+		if(_files[i].size == file.size and _files[i].modificationTime == file.modificationTime) {
+			return UNCHANGEDFILE;
+		}
+		return CHANGEDFILE;
+	}
+	return NEWFILE;
+
+}
@@ -0,0 +1,64 @@
+#ifndef ANTOK_INCREMENTAL_MANIFEST_H
+#define ANTOK_INCREMENTAL_MANIFEST_H
+
+#include<string>
+#include<vector>
+
+#include<Rtypes.h>
+
+class TFile;
+
+namespace antok {
+
+	// List of the input files already merged into a cumulative output, kept
+	// in the output file itself, so that the output and its manifest are only
+	// ever replaced together. The first line holds the hash of the
+	// configuration the output was made with, every further line one input
+	// file's path, size and modification time.
+	class IncrementalManifest {
+
+	  public:
+
+		struct inputFile {
+			std::string path;
+			Long64_t size;
+			Long64_t modificationTime;
+			inputFile()
+				: size(0),
+				  modificationTime(0) { };
+		};
+
+		enum {
+			NEWFILE,
+			UNCHANGEDFILE,
+			CHANGEDFILE
+		};
+
+		IncrementalManifest(ULong64_t configHash);
+
+		// false if there is no output, it has no manifest or the manifest belongs to another configuration
+		bool read(const std::string& outFileName);
+		// into the merged output, before it replaces the cumulative output
+		bool write(TFile* outFile) const;
+
+		static const char* objectName() { return "antokIncrementalManifest"; }
+
+		// path, size and modification time of a file on disk
+		static bool getInputFile(const std::string& path, inputFile& file);
+
+		int getState(const inputFile& file) const;
+		void add(const inputFile& file) { _files.push_back(file); }
+		void clear() { _files.clear(); }
+
+		const std::vector<antok::IncrementalManifest::inputFile>& getFiles() const { return _files; }
+
+	  private:
+
+		ULong64_t _configHash;
+		std::vector<antok::IncrementalManifest::inputFile> _files;
+
+	};
+
+}
+
+#endif
@@ -1,13 +1,19 @@
 #include<initializer.h>
 
+#include<iomanip>
+#include<set>
 #include<sstream>
 
 #include<TFile.h>
 #include<TH1D.h>
+#include<TRandom3.h>
+#include<TStopwatch.h>
 #include<TTree.h>
 
+#include<branch_widener.h>
 #include<constants.h>
 #include<cut.hpp>
+#include<cut_pattern_cache.h>
 #include<cutter.h>
 #include<entryPoint.hpp>
 #include<event.h>
@@ -17,11 +23,27 @@
 #include<generators_functions.h>
 #include<generators_plots.h>
 #include<object_manager.h>
+#include<output_options.h>
 #include<plotter.h>
+#include<quantity_cache.h>
+#include<summary_plot.h>
+#include<tree_writer.h>
 #include<yaml_utils.hpp>
 
 antok::Initializer* antok::Initializer::_initializer = 0;
 
+namespace {
+
+	// the caches are keyed to one particular input file, the UUID in the
+	// ROOT file header changes whenever the file is written anew
+	std::string __getInputFileId(TFile* inFile) {
+		std::string inFileName = inFile->GetName();
+		inFileName = inFileName.substr(inFileName.find_last_of('/') + 1);
+		return inFileName + " " + inFile->GetUUID().AsString();
+	}
+
+}
+
 antok::Initializer* antok::Initializer::instance() {
 
 	if(_initializer == 0) {
@@ -37,6 +59,172 @@ antok::Initializer::Initializer()
 
 };
 
+bool antok::Initializer::initAll() {
+
+	const unsigned int nSteps = 4;
+	const char* stepNames[nSteps] = { "Data", "Event", "Cutter", "Plotter" };
+	bool (antok::Initializer::*steps[nSteps])() = { &antok::Initializer::initializeData,
+	                                                &antok::Initializer::initializeEvent,
+	                                                &antok::Initializer::initializeCutter,
+	                                                &antok::Initializer::initializePlotter };
+	std::stringstream breakdown;
+	breakdown<<std::fixed<<std::setprecision(2);
+	double totalTime = 0.;
+	for(unsigned int i = 0; i < nSteps; ++i) {
+		TStopwatch stopwatch;
+		stopwatch.Start();
+		const bool success = (this->*steps[i])();
+		stopwatch.Stop();
+		totalTime += stopwatch.RealTime();
+		breakdown<<(i ? ", " : "")<<stepNames[i]<<" "<<stopwatch.RealTime()<<" s";
+		if(not success) {
+			return false;
+		}
+	}
+	std::stringstream strStr;
+	strStr<<std::fixed<<std::setprecision(2)<<totalTime;
+	std::cout<<"Initialization took "<<strStr.str()<<" s ("<<breakdown.str()<<")."<<std::endl;
+	return true;
+
+}
+
+bool antok::Initializer::readOutputOptions(antok::OutputOptions& outputOptions) const {
+
+	if(_config == 0) {
+		std::cerr<<"Trying to read the \"OutputOptions\" without having read the config file first."<<std::endl;
+		return false;
+	}
+	const YAML::Node& config = *_config;
+	if(not antok::YAMLUtils::hasNodeKey(config, "OutputOptions")) {
+		return true;
+	}
+	return outputOptions.read(config["OutputOptions"]);
+
+}
+
+ULong64_t antok::Initializer::getConfigHash() const {
+
+	if(_config == 0) {
+		std::cerr<<"Trying to get the hash of the config file before reading it."<<std::endl;
+		return 0;
+	}
+	return antok::YAMLUtils::getHash(*_config);
+
+}
+
+bool antok::Initializer::canSwitchFiles() const {
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	if(objectManager->_cutter == 0 or objectManager->_event == 0 or objectManager->_plotter == 0) {
+		std::cerr<<"Cannot switch files before everything is initialized."<<std::endl;
+		return false;
+	}
+	// both caches belong to one input file
+	if(objectManager->_cutter->_cutPatternCache != 0 or objectManager->_event->_quantityCache != 0) {
+		std::cerr<<"Cannot switch files with \"CutPatternCache\" or \"QuantityCache\" switched on."<<std::endl;
+		return false;
+	}
+	return true;
+
+}
+
+bool antok::Initializer::switchFiles(TFile* inFile, TFile* outFile, bool accumulate) {
+
+	if(not canSwitchFiles()) {
+		return false;
+	}
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	if(not (objectManager->setInFile(inFile) and objectManager->setOutFile(outFile))) {
+		std::cerr<<"Cannot switch to a file which is not open."<<std::endl;
+		return false;
+	}
+	objectManager->_objectsToWrite.clear();
+	objectManager->_histogramsToCopy.clear();
+
+	if(not bindInputTree(inFile)) {
+		return false;
+	}
+	TTree* inTree = objectManager->getInTree();
+	if(not objectManager->getEvent().resetForNextInput()) {
+		std::cerr<<"Could not reset the \"CalculatedQuantities\" for the next input file."<<std::endl;
+		return false;
+	}
+
+	antok::OutputOptions outputOptions;
+	if(not readOutputOptions(outputOptions)) {
+		std::cerr<<"Could not read the \"OutputOptions\"."<<std::endl;
+		return false;
+	}
+	outputOptions.applyToFile(outFile);
+
+	// the old output trees were deleted together with their file
+	antok::Cutter& cutter = objectManager->getCutter();
+	const bool asynchronousWriting = cutter._treeWriter->isAsynchronous();
+	const unsigned int writerQueueSize = cutter._treeWriter->getQueueSize();
+	const bool parallelCompression = cutter._treeWriter->usesParallelCompression();
+	delete cutter._treeWriter;
+	cutter._treeWriter = new antok::TreeWriter(asynchronousWriting, writerQueueSize, parallelCompression);
+	if(not cutter._treeWriter->setBranchPrecisions(outputOptions.branchPrecisions, objectManager->getData())) {
+		return false;
+	}
+	for(std::map<std::string, std::vector<antok::Cut*> >::const_iterator cutTrain_it = cutter._cutTrainsCutOrderMap.begin();
+	    cutTrain_it != cutter._cutTrainsCutOrderMap.end();
+	    ++cutTrain_it)
+	{
+		const std::string& cutTrainName = cutTrain_it->first;
+		outFile->cd();
+		outFile->mkdir(cutTrainName.c_str());
+		std::map<std::string, TTree*>::iterator outTree_it = cutter._outTreeMap.find(cutTrainName);
+		if(outTree_it == cutter._outTreeMap.end()) {
+			continue;
+		}
+		outFile->cd(cutTrainName.c_str());
+		TTree* outTree = outputOptions.cloneTree(inTree);
+		outputOptions.applyToTree(outTree);
+		outTree_it->second = outTree;
+		objectManager->registerObjectToWrite(TDirectory::CurrentDirectory(), outTree);
+		if(not cutter._treeWriter->addTree(outTree, cutter.getAllCutsCutmaskForCutTrain(cutTrainName))) {
+			return false;
+		}
+	}
+	outFile->cd();
+	if(not cutter._treeWriter->start()) {
+		std::cerr<<"Could not start the writer for the output TTrees."<<std::endl;
+		return false;
+	}
+
+	antok::Plotter& plotter = objectManager->getPlotter();
+	if(not plotter.resetForNextOutput(accumulate)) {
+		return false;
+	}
+	if(not plotter._waterfallHistograms.empty()) {
+		// the steps before antok's cuts are counted in the new input file, without
+		// accumulating the reset histograms get just these
+		TH1* statsHist = dynamic_cast<TH1*>(inFile->Get(plotter._statisticsHistInName.c_str()));
+		if(statsHist == 0) {
+			std::cerr<<"Could not get the input \"StatisticsHistogram\" from the input file."<<std::endl;
+			return false;
+		}
+		for(unsigned int i = 0; i < plotter._waterfallHistograms.size(); ++i) {
+			if(not plotter._waterfallHistograms[i].addInputBins(statsHist)) {
+				return false;
+			}
+		}
+	}
+	// there is one waterfall histogram per cut train, made in the same order
+	unsigned int waterfall_i = 0;
+	for(std::map<std::string, std::vector<antok::Cut*> >::const_iterator cutTrain_it = cutter._cutTrainsCutOrderMap.begin();
+	    cutTrain_it != cutter._cutTrainsCutOrderMap.end() and waterfall_i < plotter._waterfallHistograms.size();
+	    ++cutTrain_it, ++waterfall_i)
+	{
+		TDirectory* cutTrainDir = outFile->GetDirectory(cutTrain_it->first.c_str());
+		objectManager->registerObjectToWrite(cutTrainDir, plotter._waterfallHistograms[waterfall_i].histogram);
+	}
+
+	return true;
+
+}
+
 bool antok::Initializer::readConfigFile(const std::string& filename) {
 
 	using antok::YAMLUtils::hasNodeKey;
@@ -123,13 +311,20 @@ bool antok::Initializer::initializeCutter() {
 		std::cerr<<"Output file not registered."<<std::endl;
 		return false;
 	}
-	outFile->mkdir("tmptmptmp");
 	TTree* inTree = objectManager->getInTree();
 	if(inTree == 0) {
 		std::cerr<<"Input TTree not registered."<<std::endl;
 		return false;
 	}
 
+	antok::OutputOptions outputOptions;
+	if(not readOutputOptions(outputOptions)) {
+		std::cerr<<"Could not read the \"OutputOptions\"."<<std::endl;
+		return false;
+	}
+	outputOptions.applyToFile(outFile);
+
+	std::map<std::string, YAML::Node> cutEntries;
 	for(YAML::const_iterator cutTrain_it = config["CutTrains"].begin(); cutTrain_it != config["CutTrains"].end(); ++cutTrain_it) {
 
 		const YAML::Node& cutTrain = (*cutTrain_it);
@@ -166,11 +361,15 @@ bool antok::Initializer::initializeCutter() {
 
 		outFile->cd();
 		outFile->mkdir(cutTrainName.c_str());
-		outFile->cd("tmptmptmp");
-		TDirectory::CurrentDirectory()->mkdir(cutTrainName.c_str());
 		if(pertinent) {
 			outFile->cd(cutTrainName.c_str());
-			TTree* outTree = inTree->CloneTree(0);
+			TTree* outTree = outputOptions.cloneTree(inTree);
+			antok::Event& event = objectManager->getEvent();
+			if(event._quantityCache and event._quantityCache->isReading()) {
+				// the cached quantities are no input branches of the output trees
+				outTree->RemoveFriend(event._quantityCache->getTree());
+			}
+			outputOptions.applyToTree(outTree);
 			cutter._outTreeMap[cutTrainName] = outTree;
 			assert(objectManager->registerObjectToWrite(TDirectory::CurrentDirectory(), outTree));
 		}
@@ -209,19 +408,273 @@ bool antok::Initializer::initializeCutter() {
 			}
 			cutter._cutTrainsMap[cutTrainName][shortName] = antokCut;
 			cutter._cutTrainsCutOrderMap[cutTrainName].push_back(antokCut);
+			cutEntries[shortName] = cutEntry;
 
 		}
 
 	} // End loop over CutTrains
 
+	if(not initializeVariations(cutEntries)) {
+		std::cerr<<"Could not initialize the \"Variations\"."<<std::endl;
+		return false;
+	}
+
+	if(cutter._cuts.size() > 8*sizeof(long)) {
+		std::cerr<<"Too many different cuts ("<<cutter._cuts.size()<<"), at most "<<8*sizeof(long)<<" are supported."<<std::endl;
+		return false;
+	}
+
+	bool asynchronousWriting = true;
+	unsigned int writerQueueSize = 1024;
+	bool parallelCompression = false;
+	if(hasNodeKey(config, "OutputOptions")) {
+		const YAML::Node& outputOptions = config["OutputOptions"];
+		if(hasNodeKey(outputOptions, "AsynchronousTreeWriting")) {
+			std::string asyncOption = antok::YAMLUtils::getString(outputOptions["AsynchronousTreeWriting"]);
+			if(asyncOption == "On") {
+				asynchronousWriting = true;
+			} else if(asyncOption != "Off") {
+				std::cerr<<"Entry \"AsynchronousTreeWriting\" in \"OutputOptions\" has to be either \"On\" or \"Off\"."<<std::endl;
+				return false;
+			}
+		}
+		if(hasNodeKey(outputOptions, "WriterQueueSize")) {
+			if(not antok::YAMLUtils::getValue<unsigned int>(outputOptions["WriterQueueSize"], &writerQueueSize) or writerQueueSize == 0) {
+				std::cerr<<"Entry \"WriterQueueSize\" in \"OutputOptions\" has to be a positive integer."<<std::endl;
+				return false;
+			}
+		}
+		if(hasNodeKey(outputOptions, "ParallelCompression")) {
+			std::string parallelOption = antok::YAMLUtils::getString(outputOptions["ParallelCompression"]);
+			if(parallelOption == "On") {
+				parallelCompression = true;
+			} else if(parallelOption != "Off") {
+				std::cerr<<"Entry \"ParallelCompression\" in \"OutputOptions\" has to be either \"On\" or \"Off\"."<<std::endl;
+				return false;
+			}
+		}
+	}
+
+	cutter._treeWriter = new antok::TreeWriter(asynchronousWriting, writerQueueSize, parallelCompression);
+	if(not cutter._treeWriter->setBranchPrecisions(outputOptions.branchPrecisions, objectManager->getData())) {
+		std::cerr<<"Could not set up the \"BranchPrecision\" of the output TTrees."<<std::endl;
+		return false;
+	}
 	for(std::map<std::string, TTree*>::const_iterator outTree_it = cutter._outTreeMap.begin(); outTree_it != cutter._outTreeMap.end(); ++outTree_it) {
-		cutter._treesToFill.push_back(std::pair<TTree*, long>(outTree_it->second, cutter.getAllCutsCutmaskForCutTrain(outTree_it->first)));
+		if(not cutter._treeWriter->addTree(outTree_it->second, cutter.getAllCutsCutmaskForCutTrain(outTree_it->first))) {
+			std::cerr<<"Could not add the output TTree of cutTrain \""<<outTree_it->first<<"\" to the writer."<<std::endl;
+			return false;
+		}
+	}
+	if(not cutter._treeWriter->start()) {
+		std::cerr<<"Could not start the writer for the output TTrees."<<std::endl;
+		return false;
+	}
+
+	if(hasNodeKey(config, "CutPatternCache")) {
+		const YAML::Node& cacheOptions = config["CutPatternCache"];
+		bool state = false;
+		std::string stateOption = antok::YAMLUtils::getString(cacheOptions["State"]);
+		if(stateOption == "On") {
+			state = true;
+		} else if(stateOption != "Off") {
+			std::cerr<<"Entry \"State\" in \"CutPatternCache\" has to be either \"On\" or \"Off\"."<<std::endl;
+			return false;
+		}
+		if(state and objectManager->isPreview()) {
+			// the sidecar holds the cut patterns of all entries in order
+			std::cerr<<"Warning: \"CutPatternCache\" is not used in \"Preview\" mode."<<std::endl;
+			state = false;
+		}
+		if(state) {
+			std::string directory = ".";
+			if(hasNodeKey(cacheOptions, "Directory")) {
+				directory = antok::YAMLUtils::getString(cacheOptions["Directory"]);
+				if(directory == "") {
+					std::cerr<<"Could not convert \"Directory\" in \"CutPatternCache\" to std::string."<<std::endl;
+					return false;
+				}
+			}
+			std::string inFileName = objectManager->getInFile()->GetName();
+			inFileName = inFileName.substr(inFileName.find_last_of('/') + 1);
+			std::stringstream strStr;
+			strStr<<directory<<"/"<<inFileName<<".cutpattern";
+			// everything except plotting and output options can change the cut patterns
+			ULong64_t configHash = antok::YAMLUtils::getHash(__getInputFileId(objectManager->getInFile()));
+			for(YAML::const_iterator config_it = config.begin(); config_it != config.end(); ++config_it) {
+				std::string sectionName = antok::YAMLUtils::getString(config_it->first);
+				if(sectionName == "Plots" or sectionName == "GlobalPlotOptions" or
+				   sectionName == "OutputOptions" or sectionName == "CutPatternCache" or
+				   sectionName == "QuantityCache" or sectionName == "Preview")
+				{
+					continue;
+				}
+				configHash = antok::YAMLUtils::getHash(sectionName, configHash);
+				configHash = antok::YAMLUtils::getHash(config_it->second, configHash);
+			}
+			cutter._cutPatternCache = new antok::CutPatternCache(strStr.str(), configHash, cutter._cuts.size());
+			if(cutter._cutPatternCache->load(inTree->GetEntries())) {
+				std::cout<<"Reading cut patterns from sidecar \""<<strStr.str()<<"\"."<<std::endl;
+			}
+		}
 	}
 
 	return true;
 
 };
 
+bool antok::Initializer::initializeVariations(const std::map<std::string, YAML::Node>& cutEntries) {
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	YAML::Node& config = (*_config);
+	if(not hasNodeKey(config, "Variations")) {
+		return true;
+	}
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Cutter& cutter = objectManager->getCutter();
+	TFile* outFile = objectManager->getOutFile();
+
+	// Every variation gets its own copy of each cut train which contains one of
+	// the varied cuts. Reading the input and the calculated quantities are shared
+	// between all of them, only the varied cuts are evaluated again.
+	const std::map<std::string, std::vector<antok::Cut*> > originalCutTrains = cutter._cutTrainsCutOrderMap;
+	for(YAML::const_iterator variation_it = config["Variations"].begin(); variation_it != config["Variations"].end(); ++variation_it) {
+
+		const YAML::Node& variation = (*variation_it);
+		std::string variationName = antok::YAMLUtils::getString(variation["Name"]);
+		if(variationName == "") {
+			std::cerr<<"\"Name\" missing or invalid for one of the \"Variations\"."<<std::endl;
+			return false;
+		}
+		if(not (hasNodeKey(variation, "Cuts") and variation["Cuts"].IsSequence())) {
+			std::cerr<<"\"Cuts\" missing or not a sequence in \"Variation\" \""<<variationName<<"\"."<<std::endl;
+			return false;
+		}
+		for(YAML::const_iterator key_it = variation.begin(); key_it != variation.end(); ++key_it) {
+			std::string key = antok::YAMLUtils::getString(key_it->first);
+			if(key == "Constants") {
+				// the calculated quantities hold the addresses of the constants
+				std::cerr<<"\"Constants\" cannot be varied (\"Variation\" \""<<variationName<<"\"), "
+				         <<"vary the parameters of the cuts which use them instead."<<std::endl;
+				return false;
+			}
+			if(key != "Name" and key != "Cuts") {
+				std::cerr<<"Unknown entry \""<<key<<"\" in \"Variation\" \""<<variationName<<"\"."<<std::endl;
+				return false;
+			}
+		}
+
+		std::map<antok::Cut*, antok::Cut*> variedCuts;
+		for(YAML::const_iterator cuts_it = variation["Cuts"].begin(); cuts_it != variation["Cuts"].end(); ++cuts_it) {
+
+			const YAML::Node& override = (*cuts_it);
+			std::string shortName = antok::YAMLUtils::getString(override["ShortName"]);
+			std::map<std::string, YAML::Node>::const_iterator cutEntry_it = cutEntries.find(shortName);
+			if(cutEntry_it == cutEntries.end()) {
+				std::cerr<<"Cut \""<<shortName<<"\" in \"Variation\" \""<<variationName<<"\" is not used in any \"CutTrain\"."<<std::endl;
+				return false;
+			}
+			YAML::Node variedEntry = YAML::Clone(cutEntry_it->second);
+			if(antok::YAMLUtils::getString(variedEntry["Cut"]["Name"]) == "Group") {
+				std::cerr<<"\"Group\" cut \""<<shortName<<"\" cannot be varied in \"Variation\" \""<<variationName<<"\"."<<std::endl;
+				return false;
+			}
+			for(YAML::const_iterator parameter_it = override.begin(); parameter_it != override.end(); ++parameter_it) {
+				std::string parameterName = antok::YAMLUtils::getString(parameter_it->first);
+				if(parameterName == "ShortName") {
+					continue;
+				}
+				if(hasNodeKey(config, "Constants") and hasNodeKey(config["Constants"], parameterName)) {
+					std::cerr<<"Constant \""<<parameterName<<"\" cannot be varied in \"Variation\" \""<<variationName<<"\", "
+					         <<"vary the parameters of the cuts which use it instead."<<std::endl;
+					return false;
+				}
+				if(not hasNodeKey(cutEntry_it->second["Cut"], parameterName)) {
+					std::cerr<<"Cut \""<<shortName<<"\" has no parameter \""<<parameterName<<"\" to vary in \"Variation\" \""<<variationName<<"\"."<<std::endl;
+					return false;
+				}
+				if(not parameter_it->second.IsScalar()) {
+					std::cerr<<"Parameter \""<<parameterName<<"\" of cut \""<<shortName<<"\" in \"Variation\" \""<<variationName<<"\" has to be a number or a variable name."<<std::endl;
+					return false;
+				}
+				variedEntry["Cut"][parameterName] = parameter_it->second;
+			}
+			variedEntry["ShortName"] = shortName + "@" + variationName;
+			variedEntry["LongName"] = antok::YAMLUtils::getString(variedEntry["LongName"]) + " [" + variationName + "]";
+			variedEntry["Abbreviation"] = antok::YAMLUtils::getString(variedEntry["Abbreviation"]) + "@" + variationName;
+
+			if(cutter._cutsMap.count(shortName + "@" + variationName) > 0) {
+				std::cerr<<"Cut \""<<shortName<<"\" varied twice in \"Variation\" \""<<variationName<<"\"."<<std::endl;
+				return false;
+			}
+			antok::Cut* antokCut = 0;
+			bool* result = 0;
+			if(not antok::generators::generateCut(variedEntry, antokCut, result)) {
+				std::cerr<<"Could not generate cut \""<<shortName<<"\" for \"Variation\" \""<<variationName<<"\"."<<std::endl;
+				return false;
+			}
+			cutter._cutsMap[antokCut->getShortName()] = antokCut;
+			cutter._cuts.push_back(std::pair<antok::Cut*, bool*>(antokCut, result));
+			variedCuts[cutter._cutsMap[shortName]] = antokCut;
+
+		}
+
+		for(std::map<std::string, std::vector<antok::Cut*> >::const_iterator cutTrain_it = originalCutTrains.begin();
+		    cutTrain_it != originalCutTrains.end();
+		    ++cutTrain_it)
+		{
+			const std::vector<antok::Cut*>& cuts = cutTrain_it->second;
+			bool affected = false;
+			for(unsigned int i = 0; i < cuts.size(); ++i) {
+				if(variedCuts.find(cuts[i]) != variedCuts.end()) {
+					affected = true;
+					break;
+				}
+			}
+			if(not affected) {
+				continue;
+			}
+			std::string cutTrainName = cutTrain_it->first + " [" + variationName + "]";
+			if(cutter._cutTrainsCutOrderMap.count(cutTrainName) > 0) {
+				std::cerr<<"\"Variation\" \""<<variationName<<"\" defined twice."<<std::endl;
+				return false;
+			}
+			std::vector<antok::Cut*> variedTrain;
+			for(unsigned int i = 0; i < cuts.size(); ++i) {
+				std::map<antok::Cut*, antok::Cut*>::const_iterator varied_it = variedCuts.find(cuts[i]);
+				antok::Cut* antokCut = (varied_it == variedCuts.end()) ? cuts[i] : varied_it->second;
+				variedTrain.push_back(antokCut);
+				cutter._cutTrainsMap[cutTrainName][antokCut->getShortName()] = antokCut;
+			}
+			cutter._cutTrainsCutOrderMap[cutTrainName] = variedTrain;
+			outFile->cd();
+			outFile->mkdir(cutTrainName.c_str());
+		}
+
+	}
+
+	return true;
+
+}
+
+namespace {
+
+	// compact input types are read into the Data slot of the wider type
+	std::string __getWidenedType(const std::string& type) {
+		if(type == "float" or type == "Float16_t") {
+			return "double";
+		} else if(type == "short") {
+			return "int";
+		} else if(type == "std::vector<float>") {
+			return "std::vector<double>";
+		}
+		return "";
+	}
+
+}
+
 bool antok::Initializer::initializeData() {
 
 	using antok::YAMLUtils::hasNodeKey;
@@ -254,6 +707,7 @@ bool antok::Initializer::initializeData() {
 	// Get all the branches in the tree and fill the data maps
 	YAML::Node perEventTreeBranches= config["TreeBranches"]["onePerEvent"];
 	YAML::Node perParticleTreeBranches= config["TreeBranches"]["onePerParticle"];
+	std::vector<std::pair<std::string, std::string> > compactBranches;
 	for(YAML::const_iterator typeIt = perEventTreeBranches.begin(); typeIt != perEventTreeBranches.end(); ++typeIt) {
 		for(YAML::const_iterator valIt = typeIt->second.begin(); valIt != typeIt->second.end(); ++valIt) {
 			std::string type = antok::YAMLUtils::getString(typeIt->first);
@@ -262,6 +716,11 @@ bool antok::Initializer::initializeData() {
 				std::cerr<<"Conversion to std::string failed for one of the \"TreeBranches\"' \"onePerEvent\" "<<type<<"s."<<std::endl;
 				return false;
 			}
+			const std::string widenedType = __getWidenedType(type);
+			if(widenedType != "") {
+				compactBranches.push_back(std::pair<std::string, std::string>(name, type));
+				type = widenedType;
+			}
 			if(type == "double") {
 				if(not data.insert<double>(name)) {
 					std::cerr<<antok::Data::getVariableInsertionErrorMsg(name);
@@ -310,6 +769,15 @@ bool antok::Initializer::initializeData() {
 				std::cerr<<"Conversion to std::string failed for one of the \"TreeBranches\"' \"onePerParticle\" "<<type<<"s."<<std::endl;
 				return false;
 			}
+			const std::string widenedType = __getWidenedType(type);
+			if(widenedType != "") {
+				for(unsigned int i = 0; i < N_PARTICLES; ++i) {
+					std::stringstream strStr;
+					strStr<<baseName<<(i+1);
+					compactBranches.push_back(std::pair<std::string, std::string>(strStr.str(), type));
+				}
+				type = widenedType;
+			}
 
 			if(type == "double") {
 				for(unsigned int i = 0; i < N_PARTICLES; ++i) {
@@ -375,12 +843,94 @@ bool antok::Initializer::initializeData() {
 		}
 	}
 
+	// Compact branches are read by the widener, everything else in Data up to
+	// now directly from the input tree
+	_compactBranchNames.clear();
+	if(not compactBranches.empty()) {
+		objectManager->_branchWidener = new antok::BranchWidener();
+		antok::BranchWidener& widener = *(objectManager->_branchWidener);
+		for(unsigned int i = 0; i < compactBranches.size(); ++i) {
+			const std::string& name = compactBranches[i].first;
+			const std::string& type = compactBranches[i].second;
+			if(type == "short") {
+				widener.addShort(name, data.getAddr<int>(name));
+			} else if(type == "std::vector<float>") {
+				widener.addFloatVector(name, data.getAddr<std::vector<double> >(name));
+			} else {
+				widener.addFloat(name, data.getAddr<double>(name));
+			}
+			_compactBranchNames.insert(name);
+		}
+	}
+	for(std::map<std::string, std::string>::const_iterator it = data.global_map.begin(); it != data.global_map.end(); ++it) {
+		if(_compactBranchNames.count(it->first) == 0) {
+			_inputBranchNames.insert(it->first);
+		}
+	}
+	if(not bindInputTree(objectManager->getInFile())) {
+		return false;
+	}
+
+	if(hasNodeKey(config, "Preview")) {
+		const YAML::Node& previewOptions = config["Preview"];
+		std::string stateOption = antok::YAMLUtils::getString(previewOptions["State"]);
+		if(stateOption != "On" and stateOption != "Off") {
+			std::cerr<<"Entry \"State\" in \"Preview\" has to be either \"On\" or \"Off\"."<<std::endl;
+			return false;
+		}
+		if(stateOption == "On" and objectManager->_previewDisabled) {
+			std::cerr<<"Warning: \"Preview\" is switched off in this mode."<<std::endl;
+		} else if(stateOption == "On") {
+			if(not hasNodeKey(previewOptions, "ClusterPrescale")) {
+				std::cerr<<"\"Preview\" is switched on, but has no \"ClusterPrescale\"."<<std::endl;
+				return false;
+			}
+			try {
+				objectManager->_previewClusterPrescale = previewOptions["ClusterPrescale"].as<unsigned int>();
+				if(hasNodeKey(previewOptions, "ClusterOffset")) {
+					objectManager->_previewClusterOffset = previewOptions["ClusterOffset"].as<unsigned int>();
+				}
+			} catch (const YAML::TypedBadConversion<unsigned int>& e) {
+				std::cerr<<"Could not convert \"ClusterPrescale\" or \"ClusterOffset\" in \"Preview\" to unsigned int."<<std::endl;
+				return false;
+			}
+			if(objectManager->_previewClusterPrescale == 0 or objectManager->_previewClusterOffset >= objectManager->_previewClusterPrescale) {
+				std::cerr<<"\"ClusterPrescale\" in \"Preview\" has to be positive and larger than the \"ClusterOffset\"."<<std::endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+
+}
+
+namespace {
+
+	template<typename T>
+	void __setBranchAddresses(TTree* tree, std::map<std::string, T>& variables, const std::set<std::string>& names) {
+		for(typename std::map<std::string, T>::iterator it = variables.begin(); it != variables.end(); ++it) {
+			if(names.count(it->first) > 0) {
+				tree->SetBranchAddress(it->first.c_str(), &(it->second));
+			}
+		}
+	}
+
+}
+
+bool antok::Initializer::bindInputTree(TFile* inFile) {
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	YAML::Node& config = *_config;
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Data& data = objectManager->getData();
+
 	// Set the branch addresses of the tree
 	if(not hasNodeKey(config, "TreeName")) {
 		std::cerr<<"\"TreeName\" not found in configuration file."<<std::endl;
 		return false;
 	}
-	TFile* inFile = objectManager->getInFile();
 	std::string treeName = antok::YAMLUtils::getString(config["TreeName"]);
 	if(treeName == "") {
 		std::cerr<<"Could not convert entry \"TreeName\" to std::string."<<std::endl;
@@ -393,25 +943,15 @@ bool antok::Initializer::initializeData() {
 	}
 	objectManager->_inTree = inTree;
 
-	for(std::map<std::string, double>::iterator it = data.doubles.begin(); it != data.doubles.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
-	}
-	for(std::map<std::string, int>::iterator it = data.ints.begin(); it != data.ints.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
-	}
-	for(std::map<std::string, Long64_t>::iterator it = data.long64_ts.begin(); it != data.long64_ts.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
-	}
-	for(std::map<std::string, std::vector<double>* >::iterator it = data.doubleVectors.begin(); it != data.doubleVectors.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
-	}
-	for(std::map<std::string, TLorentzVector>::iterator it = data.lorentzVectors.begin(); it != data.lorentzVectors.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
-	}
-	for(std::map<std::string, TVector3>::iterator it = data.vectors.begin(); it != data.vectors.end(); ++it) {
-		inTree->SetBranchAddress(it->first.c_str(), &(it->second));
+	__setBranchAddresses(inTree, data.doubles, _inputBranchNames);
+	__setBranchAddresses(inTree, data.ints, _inputBranchNames);
+	__setBranchAddresses(inTree, data.long64_ts, _inputBranchNames);
+	__setBranchAddresses(inTree, data.doubleVectors, _inputBranchNames);
+	__setBranchAddresses(inTree, data.lorentzVectors, _inputBranchNames);
+	__setBranchAddresses(inTree, data.vectors, _inputBranchNames);
+	if(objectManager->_branchWidener and not objectManager->_branchWidener->setBranchAddresses(inTree)) {
+		return false;
 	}
-
 	return true;
 
 }
@@ -437,6 +977,10 @@ bool antok::Initializer::initializeEvent() {
 	if(not hasNodeKey(config, "CalculatedQuantities")) {
 		std::cerr<<"Warning: \"CalculatedQuantities\" not found in configuration file."<<std::endl;
 	}
+	antok::Event& event = objectManager->getEvent();
+	antok::Data& data = objectManager->getData();
+	// output names of every registered function, to drop the cached ones later
+	std::vector<std::vector<std::string> > functionQuantityNames;
 	for(YAML::const_iterator calcQuantity_it = config["CalculatedQuantities"].begin(); calcQuantity_it != config["CalculatedQuantities"].end(); ++calcQuantity_it) {
 
 		YAML::Node calcQuantity = (*calcQuantity_it);
@@ -504,6 +1048,7 @@ bool antok::Initializer::initializeEvent() {
 				}
 			}
 
+			data.takeRequestedNames();
 			antok::Function* antokFunctionPtr = 0;
 			if(functionName == "abs") {
 				antokFunctionPtr = antok::generators::generateAbs(function, quantityNames, indices[indices_i]);
@@ -525,6 +1070,8 @@ bool antok::Initializer::initializeEvent() {
 				antokFunctionPtr = antok::generators::generateGetTs(function, quantityNames, indices[indices_i]);
 			} else if(functionName == "getVector3") {
 				antokFunctionPtr = antok::generators::generateGetVector3(function, quantityNames, indices[indices_i]);
+			} else if(functionName == "joinExternalTable") {
+				antokFunctionPtr = antok::generators::generateJoinExternalTable(function, quantityNames, indices[indices_i]);
 			} else if(functionName == "mass") {
 				antokFunctionPtr = antok::generators::generateMass(function, quantityNames, indices[indices_i]);
 			} else if(functionName == "radToDegree") {
@@ -551,13 +1098,99 @@ bool antok::Initializer::initializeEvent() {
 				std::cerr<<quantityNames[quantityNames.size() - 1]<<"]."<<std::endl;
 				return false;
 			}
-			antok::Event& event = objectManager->getEvent();
 			event._functions.push_back(antokFunctionPtr);
+			functionQuantityNames.push_back(quantityNames);
+			std::set<std::string> inputNames = data.takeRequestedNames();
+			for(unsigned int i = 0; i < quantityNames.size(); ++i) {
+				inputNames.erase(quantityNames[i]);
+			}
+			_functionInputNames[antokFunctionPtr] = inputNames;
+			_functionOutputNames[antokFunctionPtr] = quantityNames;
 
 		}
 
 	}
 
+	if(hasNodeKey(config, "QuantityCache")) {
+		const YAML::Node& cacheOptions = config["QuantityCache"];
+		bool state = false;
+		std::string stateOption = antok::YAMLUtils::getString(cacheOptions["State"]);
+		if(stateOption == "On") {
+			state = true;
+		} else if(stateOption != "Off") {
+			std::cerr<<"Entry \"State\" in \"QuantityCache\" has to be either \"On\" or \"Off\"."<<std::endl;
+			return false;
+		}
+		if(state and objectManager->isPreview()) {
+			// the cache has to hold every entry of the input
+			std::cerr<<"Warning: \"QuantityCache\" is not used in \"Preview\" mode."<<std::endl;
+			state = false;
+		}
+		if(state) {
+			std::string directory = ".";
+			if(hasNodeKey(cacheOptions, "Directory")) {
+				directory = antok::YAMLUtils::getString(cacheOptions["Directory"]);
+				if(directory == "") {
+					std::cerr<<"Could not convert \"Directory\" in \"QuantityCache\" to std::string."<<std::endl;
+					return false;
+				}
+			}
+			std::vector<std::string> cachedQuantities;
+			if(not hasNodeKey(cacheOptions, "Quantities")) {
+				std::cerr<<"\"QuantityCache\" is switched on, but has no \"Quantities\"."<<std::endl;
+				return false;
+			}
+			try {
+				cachedQuantities = cacheOptions["Quantities"].as<std::vector<std::string> >();
+			} catch (const YAML::TypedBadConversion<std::vector<std::string> >& e) {
+				std::cerr<<"Could not convert YAML sequence to std::vector<std::string> when parsing \"QuantityCache\"' \"Quantities\"."<<std::endl;
+				return false;
+			} catch (const YAML::TypedBadConversion<std::string>& e) {
+				std::cerr<<"Could not convert entries in YAML sequence to std::string when parsing \"QuantityCache\"' \"Quantities\"."<<std::endl;
+				return false;
+			}
+			std::string inFileName = objectManager->getInFile()->GetName();
+			inFileName = inFileName.substr(inFileName.find_last_of('/') + 1);
+			std::stringstream strStr;
+			strStr<<directory<<"/"<<inFileName<<".quantities.root";
+			// only the input and the sections which define the quantities can change them
+			ULong64_t configHash = antok::YAMLUtils::getHash(__getInputFileId(objectManager->getInFile()));
+			const char* sectionNames[] = { "NumberOfParticles", "TreeName", "TreeBranches", "Constants", "CalculatedQuantities" };
+			for(unsigned int i = 0; i < sizeof(sectionNames) / sizeof(sectionNames[0]); ++i) {
+				configHash = antok::YAMLUtils::getHash(sectionNames[i], configHash);
+				if(hasNodeKey(config, sectionNames[i])) {
+					configHash = antok::YAMLUtils::getHash(config[sectionNames[i]], configHash);
+				}
+			}
+			for(unsigned int i = 0; i < cachedQuantities.size(); ++i) {
+				configHash = antok::YAMLUtils::getHash(cachedQuantities[i], configHash);
+			}
+			event._quantityCache = new antok::QuantityCache(strStr.str(), configHash, cachedQuantities);
+			if(event._quantityCache->load(objectManager->getInTree(), data)) {
+				// functions whose outputs are all read from the cache are not needed anymore
+				std::set<std::string> cached(cachedQuantities.begin(), cachedQuantities.end());
+				std::vector<antok::Function*> functions;
+				for(unsigned int i = 0; i < event._functions.size(); ++i) {
+					bool allCached = true;
+					for(unsigned int j = 0; j < functionQuantityNames[i].size(); ++j) {
+						allCached = allCached and (cached.count(functionQuantityNames[i][j]) > 0);
+					}
+					if(allCached) {
+						delete event._functions[i];
+					} else {
+						functions.push_back(event._functions[i]);
+					}
+				}
+				std::cout<<"Reading "<<cachedQuantities.size()<<" quantities from cache \""<<strStr.str()<<"\", "
+				         <<"skipping "<<(event._functions.size() - functions.size())<<" of "<<event._functions.size()<<" functions."<<std::endl;
+				event._functions = functions;
+			} else if(not event._quantityCache->startWriting(data)) {
+				std::cerr<<"Could not start writing the quantity cache \""<<strStr.str()<<"\"."<<std::endl;
+				return false;
+			}
+		}
+	}
+
 	return true;
 
 };
@@ -581,8 +1214,36 @@ bool antok::Initializer::initializePlotter() {
 	objectManager->_plotter = antok::Plotter::instance();
 
 	antok::Plotter& plotter = antok::ObjectManager::instance()->getPlotter();
+	// everything the plots ask Data for from here on
+	objectManager->getData().takeRequestedNames();
 
 	antok::plotUtils::GlobalPlotOptions plotOptions(config["GlobalPlotOptions"]);
+	plotter._writeEmptyHistograms = plotOptions.writeEmptyHistograms;
+	plotter._sparseHistogramThreshold = plotOptions.sparseHistogramThreshold;
+	plotter._finishThreads = plotOptions.finishThreads;
+
+	antok::plotUtils::eventWeights& eventWeights = plotter._eventWeights;
+	for(unsigned int i = 0; i < plotOptions.eventWeightNames.size(); ++i) {
+		const std::string& weightName = plotOptions.eventWeightNames[i];
+		const double* weight = objectManager->getData().getAddr<double>(weightName);
+		if(weight == 0) {
+			std::cerr<<"Variable \""<<weightName<<"\" of the \"EventWeights\" not found in Data or not a double."<<std::endl;
+			return false;
+		}
+		eventWeights.names.push_back(weightName);
+		eventWeights.variables.push_back(weight);
+	}
+	if(plotOptions.poissonReplicas > 0) {
+		eventWeights.poissonReplicas = plotOptions.poissonReplicas;
+		eventWeights.poissonSeed = plotOptions.poissonSeed;
+		eventWeights.random = new TRandom3(plotOptions.poissonSeed);
+		for(unsigned int i = 0; i < plotOptions.poissonReplicas; ++i) {
+			std::stringstream strStr;
+			strStr<<"bs"<<i;
+			eventWeights.names.push_back(strStr.str());
+		}
+	}
+	eventWeights.values.resize(eventWeights.names.size(), 0.);
 
 	if((plotOptions.statisticsHistInName == "" or plotOptions.statisticsHistOutName == "") and
 	   not (plotOptions.statisticsHistInName == "" and plotOptions.statisticsHistOutName == ""))
@@ -598,6 +1259,14 @@ bool antok::Initializer::initializePlotter() {
 			std::cerr<<"Could not get the input \"StatisticsHistogram\" from the input file."<<std::endl;
 			return false;
 		}
+		const double* weight = 0;
+		if(plotOptions.statisticsHistWeightName != "") {
+			weight = objectManager->getData().getAddr<double>(plotOptions.statisticsHistWeightName);
+			if(weight == 0) {
+				std::cerr<<"\"Weight\" \""<<plotOptions.statisticsHistWeightName<<"\" of the \"StatisticsHistogram\" not found in Data or not a double."<<std::endl;
+				return false;
+			}
+		}
 		antok::Cutter& cutter = objectManager->getCutter();
 		TFile* outFile = objectManager->getOutFile();
 		std::vector<antok::plotUtils::waterfallHistogramContainer> waterfallHists;
@@ -612,15 +1281,18 @@ bool antok::Initializer::initializePlotter() {
 				std::cerr<<"Could not generate the output \"StatisticsHistogram\" for \"CutTrain\" \""<<cutTrainName<<"\"."<<std::endl;
 				return false;
 			}
+			// not owned by the output file, which is replaced by switchFiles()
+			statsHist->SetDirectory(0);
 			objectManager->registerObjectToWrite(TDirectory::CurrentDirectory(), statsHist);
 			std::vector<antok::Cut*> cuts = cutTrain_it->second;
 			std::vector<std::pair<const char*, const bool*> > cutsAndResults;
 			for(unsigned int i = 0; i < cuts.size(); ++i) {
 				cutsAndResults.push_back(std::pair<const char*, const bool*>(cuts[i]->getLongName().c_str(), cutter.getCutResult(cuts[i])));
 			}
-			waterfallHists.push_back(antok::plotUtils::waterfallHistogramContainer(statsHist, cutsAndResults));
+			waterfallHists.push_back(antok::plotUtils::waterfallHistogramContainer(statsHist, cutsAndResults, weight));
 		}
 		plotter._waterfallHistograms = waterfallHists;
+		plotter._statisticsHistInName = plotOptions.statisticsHistInName;
 		outFile->cd();
 	}
 
@@ -657,10 +1329,6 @@ bool antok::Initializer::initializePlotter() {
 					std::cerr<<"\"Variables\", \"LowerBounds\", \"UpperBounds\" and \"NBins\" all need to be sequences (in \"Plot\" \""<<plotName<<"\")."<<std::endl;
 					return false;
 				}
-				if(plot["Variables"].size() > 2) {
-					std::cerr<<"Cannot have \"Plot\" \""<<plotName<<"\" with more than 2 \"Variables\""<<std::endl;
-					return false;
-				}
 				if((plot["Variables"].size() != plot["LowerBounds"].size()) or
 				   (plot["Variables"].size() != plot["UpperBounds"].size()) or
 				   (plot["Variables"].size() != plot["NBins"].size()))
@@ -668,7 +1336,9 @@ bool antok::Initializer::initializePlotter() {
 					std::cerr<<"\"Variables\", \"LowerBounds\", \"UpperBounds\" and \"NBins\" need to have the same number of entries (in \"Plot\" \""<<plotName<<"\")."<<std::endl;
 					return false;
 				}
-				if(plot["Variables"].size() == 2) {
+				if(plot["Variables"].size() > 2) {
+					antokPlot = antok::generators::generateNDimPlot(plot, plotOptions);
+				} else if(plot["Variables"].size() == 2) {
 					antokPlot = antok::generators::generate2DPlot(plot, plotOptions);
 				} else if (plot["Variables"].size() == 1) {
 					antokPlot = antok::generators::generate1DPlot(plot, plotOptions);
@@ -690,10 +1360,128 @@ bool antok::Initializer::initializePlotter() {
 			std::cerr<<"Could not generate \"Plot\" \""<<plotName<<"\"."<<std::endl;
 			return false;
 		}
+		if(hasNodeKey(plot, "Weights")) {
+			std::string weightsOption = antok::YAMLUtils::getString(plot["Weights"]);
+			if(weightsOption == "On") {
+				if(plotter.getEventWeights() == 0) {
+					std::cerr<<"\"Plot\" \""<<plotName<<"\" has \"Weights\" switched on, but no \"EventWeights\" are given in the \"GlobalPlotOptions\"."<<std::endl;
+					return false;
+				}
+				if(not antokPlot->setEventWeights(plotter.getEventWeights())) {
+					std::cerr<<"\"Plot\" \""<<plotName<<"\" cannot be filled with \"Weights\"."<<std::endl;
+					return false;
+				}
+			} else if(weightsOption != "Off") {
+				std::cerr<<"Entry \"Weights\" in \"Plot\" \""<<plotName<<"\" has to be either \"On\" or \"Off\"."<<std::endl;
+				return false;
+			}
+		}
 		plotter._plots.push_back(antokPlot);
 	}
 
-	return true;
+	if(hasNodeKey(config, "Summaries")) {
+		const YAML::Node& summaries = config["Summaries"];
+		int sketchSize = 200;
+		if(hasNodeKey(summaries, "SketchSize") and
+		   (not antok::YAMLUtils::getValue<int>(summaries["SketchSize"], &sketchSize) or sketchSize < 8))
+		{
+			std::cerr<<"\"SketchSize\" of the \"Summaries\" needs to be an integer >= 8."<<std::endl;
+			return false;
+		}
+		std::vector<double> quantileLevels;
+		if(hasNodeKey(summaries, "Quantiles")) {
+			try {
+				quantileLevels = summaries["Quantiles"].as<std::vector<double> >();
+			} catch (const YAML::Exception& e) {
+				std::cerr<<"Could not convert \"Quantiles\" of the \"Summaries\" to a sequence of doubles."<<std::endl;
+				return false;
+			}
+			for(unsigned int i = 0; i < quantileLevels.size(); ++i) {
+				if(quantileLevels[i] < 0. or quantileLevels[i] > 1.) {
+					std::cerr<<"\"Quantiles\" of the \"Summaries\" need to be in [0, 1] (found "<<quantileLevels[i]<<")."<<std::endl;
+					return false;
+				}
+			}
+		}
+		if(hasNodeKey(summaries, "JsonFile")) {
+			plotter._summaryJsonFileName = antok::YAMLUtils::getString(summaries["JsonFile"]);
+		}
+		for(YAML::const_iterator summaries_it = summaries["Variables"].begin(); summaries_it != summaries["Variables"].end(); ++summaries_it) {
+			antok::SummaryPlot* summary = antok::generators::generateSummary(*summaries_it, plotOptions, sketchSize, quantileLevels);
+			if(summary == 0) {
+				std::cerr<<"Could not generate one of the \"Summaries\"."<<std::endl;
+				return false;
+			}
+			plotter._plots.push_back(summary);
+			plotter._summaries.push_back(summary);
+		}
+	}
+
+	return reduceInputForCutPatternCache(objectManager->getData().takeRequestedNames());
 
 };
 
+bool antok::Initializer::reduceInputForCutPatternCache(const std::set<std::string>& plotQuantityNames) {
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Cutter& cutter = objectManager->getCutter();
+	antok::Event& event = objectManager->getEvent();
+	// output trees are copies of the whole input, and a quantity cache being written needs every entry calculated
+	if(not cutter.cutPatternsFromCache() or not cutter._outTreeMap.empty() or event.writesQuantityCache()) {
+		return true;
+	}
+
+	// the functions calculating a needed quantity make their inputs needed as well
+	std::set<std::string> neededNames = plotQuantityNames;
+	std::vector<bool> functionNeeded(event._functions.size(), false);
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(unsigned int i = 0; i < event._functions.size(); ++i) {
+			if(functionNeeded[i]) {
+				continue;
+			}
+			const std::vector<std::string>& outputNames = _functionOutputNames[event._functions[i]];
+			for(unsigned int j = 0; j < outputNames.size(); ++j) {
+				if(neededNames.count(outputNames[j]) > 0) {
+					functionNeeded[i] = true;
+					break;
+				}
+			}
+			if(functionNeeded[i]) {
+				const std::set<std::string>& inputNames = _functionInputNames[event._functions[i]];
+				neededNames.insert(inputNames.begin(), inputNames.end());
+				changed = true;
+			}
+		}
+	}
+
+	std::vector<antok::Function*> functions;
+	for(unsigned int i = 0; i < event._functions.size(); ++i) {
+		if(functionNeeded[i]) {
+			functions.push_back(event._functions[i]);
+		} else {
+			_functionInputNames.erase(event._functions[i]);
+			_functionOutputNames.erase(event._functions[i]);
+			delete event._functions[i];
+		}
+	}
+	const unsigned int nFunctions = event._functions.size();
+	event._functions = functions;
+
+	std::set<std::string> branchNames = _inputBranchNames;
+	branchNames.insert(_compactBranchNames.begin(), _compactBranchNames.end());
+	TTree* inTree = objectManager->getInTree();
+	unsigned int nDisabled = 0;
+	for(std::set<std::string>::const_iterator it = branchNames.begin(); it != branchNames.end(); ++it) {
+		if(neededNames.count(*it) == 0) {
+			inTree->SetBranchStatus(it->c_str(), false);
+			++nDisabled;
+		}
+	}
+	std::cout<<"Cut patterns from the sidecar: reading "<<(branchNames.size() - nDisabled)<<" of "<<branchNames.size()<<" input branches, "
+	         <<"calculating "<<functions.size()<<" of "<<nFunctions<<" functions."<<std::endl;
+	return true;
+
+}
+
@@ -1,17 +1,24 @@
 #ifndef ANTOK_INITIALIZER_H
 #define ANTOK_INITIALIZER_H
 
+#include<map>
+#include<set>
 #include<string>
+#include<vector>
 
 #include<yaml-cpp/yaml.h>
 
+#include<Rtypes.h>
+
 class TFile;
 class TTree;
 
 namespace antok {
 
+	struct OutputOptions;
 	class Event;
 	class Cutter;
+	class Function;
 	class ObjectManager;
 	class Plotter;
 
@@ -23,28 +30,47 @@ namespace antok {
 
 		bool readConfigFile(const std::string& filename);
 
-		bool initAll() {
-			return (
-				initializeData() and
-				initializeEvent() and
-				initializeCutter() and
-				initializePlotter()
-			);
-		}
+		// runs all of the below and prints how long each of them took
+		bool initAll();
 
 		bool initializeCutter();
 		bool initializeData();
 		bool initializeEvent();
 		bool initializePlotter();
 
+		// the "OutputOptions" of the config file, also for the tools writing their own files
+		bool readOutputOptions(antok::OutputOptions& outputOptions) const;
+		// hash of the whole config file, to recognize outputs made with it
+		ULong64_t getConfigHash() const;
+
+		// Keeps everything initialized by initAll() and continues with a new pair
+		// of files after ObjectManager::finish(). The histograms are cleared
+		// unless accumulate is set, then they are written again with the new
+		// entries added.
+		bool canSwitchFiles() const;
+		bool switchFiles(TFile* inFile, TFile* outFile, bool accumulate);
+
 	  private:
 
 		Initializer();
 
+		bool initializeVariations(const std::map<std::string, YAML::Node>& cutEntries);
+		bool bindInputTree(TFile* inFile);
+		// with the cut patterns from the sidecar, only what the plots use has to be read and calculated
+		bool reduceInputForCutPatternCache(const std::set<std::string>& plotQuantityNames);
+
 		static Initializer* _initializer;
 
 		YAML::Node* _config;
 
+		// the Data entries which are read from the input tree
+		std::set<std::string> _inputBranchNames;
+		// the input branches read by the BranchWidener
+		std::set<std::string> _compactBranchNames;
+		// the Data entries every function uses and calculates
+		std::map<const antok::Function*, std::set<std::string> > _functionInputNames;
+		std::map<const antok::Function*, std::vector<std::string> > _functionOutputNames;
+
 	};
 
 }
@@ -0,0 +1,104 @@
+#include<multi_weight_histogram.h>
+
+#include<assert.h>
+
+#include<TArrayD.h>
+#include<TH1.h>
+
+antok::MultiWeightHistogram::MultiWeightHistogram(const TH1* histTemplate, unsigned int nSlots, unsigned int sparseThreshold)
+	: _xAxis(histTemplate->GetXaxis()),
+	  _yAxis(histTemplate->GetDimension() > 1 ? histTemplate->GetYaxis() : 0),
+	  _nBinsX(_xAxis->GetNbins()),
+	  _nBinsY(_yAxis ? _yAxis->GetNbins() : 0),
+	  _nCells((_nBinsX + 2) * (_yAxis ? _nBinsY + 2 : 1)),
+	  _nSlots(nSlots),
+	  _pageShift(0),
+	  _pageMask(0),
+	  _entries(0.),
+	  _stats(7 * nSlots, 0.)
+{
+	assert(histTemplate->GetDimension() <= 2);
+	assert(_nSlots > 0);
+	// the threshold is compared to the number of sums, i.e. bins times weights
+	if((ULong64_t)_nCells * _nSlots > sparseThreshold) {
+		_pageShift = __sparsePageShift;
+	} else {
+		// one page holding all bins
+		_pageShift = 0;
+		while((1U << _pageShift) < _nCells) {
+			++_pageShift;
+		}
+	}
+	_pageMask = (1U << _pageShift) - 1;
+	_pages.resize(((_nCells - 1) >> _pageShift) + 1, 0);
+}
+
+antok::MultiWeightHistogram::~MultiWeightHistogram() {
+
+	for(unsigned int i = 0; i < _pages.size(); ++i) {
+		delete [] _pages[i];
+	}
+
+}
+
+double* antok::MultiWeightHistogram::newPage() const {
+
+	const unsigned int pageSize = 2 * (_pageMask + 1) * _nSlots;
+	double* page = new double[pageSize];
+	for(unsigned int i = 0; i < pageSize; ++i) {
+		page[i] = 0.;
+	}
+	return page;
+
+}
+
+void antok::MultiWeightHistogram::addTo(unsigned int slot, TH1* hist) const {
+
+	assert(slot < _nSlots);
+	if(isEmpty()) {
+		return;
+	}
+	double stats[7] = { 0., 0., 0., 0., 0., 0., 0. };
+	hist->GetStats(stats);
+	double entries = hist->GetEntries();
+
+	if(hist->GetSumw2N() == 0) {
+		hist->Sumw2();
+	}
+	TArrayD* sumw2 = hist->GetSumw2();
+	for(unsigned int page_i = 0; page_i < _pages.size(); ++page_i) {
+		const double* page = _pages[page_i];
+		if(not page) {
+			continue;
+		}
+		const unsigned int firstBin = page_i << _pageShift;
+		const double* pageSumW2 = page + (_pageMask + 1) * _nSlots;
+		for(unsigned int i = 0; i <= _pageMask and firstBin + i < _nCells; ++i) {
+			const double sumW2 = pageSumW2[i * _nSlots + slot];
+			if(sumW2 != 0.) {
+				hist->AddBinContent(firstBin + i, page[i * _nSlots + slot]);
+				(*sumw2)[firstBin + i] += sumW2;
+			}
+		}
+	}
+
+	const double* slotStats = &_stats[7 * slot];
+	for(unsigned int i = 0; i < (_yAxis ? 7U : 4U); ++i) {
+		stats[i] += slotStats[i];
+	}
+	hist->PutStats(stats);
+	hist->SetEntries(entries + _entries);
+
+}
+
+void antok::MultiWeightHistogram::reset() {
+
+	// give the memory back, the pages are allocated again on the next fill
+	for(unsigned int i = 0; i < _pages.size(); ++i) {
+		delete [] _pages[i];
+		_pages[i] = 0;
+	}
+	_entries = 0.;
+	_stats.assign(_stats.size(), 0.);
+
+}
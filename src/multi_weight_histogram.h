@@ -0,0 +1,114 @@
+#ifndef ANTOK_MULTI_WEIGHT_HISTOGRAM_H
+#define ANTOK_MULTI_WEIGHT_HISTOGRAM_H
+
+#include<vector>
+
+#include<TAxis.h>
+
+class TH1;
+
+namespace antok {
+
+	// Sums of weights and squared weights of a one or two dimensional
+	// histogram for several weights per entry at once. The bin is looked up
+	// once per value and the slots of all weights are stored next to each
+	// other, so filling N weights costs one lookup and N additions. Each
+	// slot is added to its own TH1 with addTo().
+	//
+	// As in the NativeHistogram, histograms with more than sparseThreshold
+	// sums (bins times weights) are stored in pages which are only allocated
+	// when one of their bins is filled.
+	class MultiWeightHistogram {
+
+	  public:
+
+		MultiWeightHistogram(const TH1* histTemplate, unsigned int nSlots, unsigned int sparseThreshold);
+		~MultiWeightHistogram();
+
+		inline void fill(double x, const double* weights);
+		inline void fill(double x, double y, const double* weights);
+
+		void addTo(unsigned int slot, TH1* hist) const;
+		void reset();
+
+		bool isEmpty() const { return _entries == 0.; }
+		unsigned int getNSlots() const { return _nSlots; }
+
+	  private:
+
+		// smaller pages than in the NativeHistogram, as every bin holds two doubles per slot
+		static const unsigned int __sparsePageShift = 8;
+
+		MultiWeightHistogram(const MultiWeightHistogram&);
+		MultiWeightHistogram& operator=(const MultiWeightHistogram&);
+
+		double* newPage() const;
+		inline void addToBin(unsigned int bin, bool inRange, double x, double y, const double* weights);
+
+		const TAxis* _xAxis;
+		const TAxis* _yAxis;
+		int _nBinsX;
+		int _nBinsY;
+		unsigned int _nCells;
+		unsigned int _nSlots;
+
+		// a page holds the sums of weights [bin * _nSlots + slot] of its bins
+		// followed by the sums of squared weights in the same layout
+		unsigned int _pageShift;
+		unsigned int _pageMask;
+		std::vector<double*> _pages;
+
+		double _entries;
+		// per slot, in the order of TH1::GetStats
+		std::vector<double> _stats;
+
+	};
+
+}
+
+inline void antok::MultiWeightHistogram::addToBin(unsigned int bin, bool inRange, double x, double y, const double* weights) {
+
+	double*& page = _pages[bin >> _pageShift];
+	if(not page) {
+		page = newPage();
+	}
+	double* sumW = page + (bin & _pageMask) * _nSlots;
+	double* sumW2 = sumW + (_pageMask + 1) * _nSlots;
+	for(unsigned int slot = 0; slot < _nSlots; ++slot) {
+		sumW[slot] += weights[slot];
+		sumW2[slot] += weights[slot] * weights[slot];
+	}
+	_entries += 1.;
+	if(not inRange) {
+		return;
+	}
+	for(unsigned int slot = 0; slot < _nSlots; ++slot) {
+		const double w = weights[slot];
+		double* stats = &_stats[7 * slot];
+		stats[0] += w;
+		stats[1] += w * w;
+		stats[2] += w * x;
+		stats[3] += w * x * x;
+		stats[4] += w * y;
+		stats[5] += w * y * y;
+		stats[6] += w * x * y;
+	}
+
+}
+
+inline void antok::MultiWeightHistogram::fill(double x, const double* weights) {
+
+	const int binX = _xAxis->FindFixBin(x);
+	addToBin(binX, binX > 0 and binX <= _nBinsX, x, 0., weights);
+
+}
+
+inline void antok::MultiWeightHistogram::fill(double x, double y, const double* weights) {
+
+	const int binX = _xAxis->FindFixBin(x);
+	const int binY = _yAxis->FindFixBin(y);
+	addToBin(binX + (_nBinsX + 2) * binY, binX > 0 and binX <= _nBinsX and binY > 0 and binY <= _nBinsY, x, y, weights);
+
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include<native_histogram.h>
+
+#include<iostream>
+
+#include<TArrayD.h>
+#include<TAxis.h>
+#include<TH1.h>
+
+antok::NativeHistogram::NativeHistogram(int nBinsX, double lowerBoundX, double upperBoundX, unsigned int sparseThreshold)
+	: _nBinsX(nBinsX),
+	  _lowerBoundX(lowerBoundX),
+	  _upperBoundX(upperBoundX),
+	  _nBinsY(0),
+	  _lowerBoundY(0.),
+	  _upperBoundY(0.),
+	  _nCells(nBinsX + 2)
+{
+	initializePages(sparseThreshold);
+	reset();
+}
+
+antok::NativeHistogram::NativeHistogram(int nBinsX, double lowerBoundX, double upperBoundX,
+                                        int nBinsY, double lowerBoundY, double upperBoundY,
+                                        unsigned int sparseThreshold)
+	: _nBinsX(nBinsX),
+	  _lowerBoundX(lowerBoundX),
+	  _upperBoundX(upperBoundX),
+	  _nBinsY(nBinsY),
+	  _lowerBoundY(lowerBoundY),
+	  _upperBoundY(upperBoundY),
+	  _nCells((nBinsX + 2) * (nBinsY + 2))
+{
+	initializePages(sparseThreshold);
+	reset();
+}
+
+antok::NativeHistogram::~NativeHistogram() {
+
+	for(unsigned int i = 0; i < _pages.size(); ++i) {
+		delete [] _pages[i];
+	}
+
+}
+
+void antok::NativeHistogram::initializePages(unsigned int sparseThreshold) {
+
+	if(_nCells > sparseThreshold) {
+		_pageShift = __sparsePageShift;
+	} else {
+		// one page holding all bins
+		_pageShift = 0;
+		while((1U << _pageShift) < _nCells) {
+			++_pageShift;
+		}
+	}
+	_pageMask = (1U << _pageShift) - 1;
+	_pages.resize(((_nCells - 1) >> _pageShift) + 1, 0);
+
+}
+
+double* antok::NativeHistogram::newPage() const {
+
+	double* page = new double[_pageMask + 1];
+	for(unsigned int i = 0; i <= _pageMask; ++i) {
+		page[i] = 0.;
+	}
+	return page;
+
+}
+
+bool antok::NativeHistogram::canRepresent(const TH1* hist) {
+
+	if(hist == 0 or hist->GetDimension() > 2) {
+		return false;
+	}
+	if(hist->GetXaxis()->IsVariableBinSize() or hist->GetXaxis()->GetXmax() <= hist->GetXaxis()->GetXmin()) {
+		return false;
+	}
+	if(hist->GetDimension() == 2) {
+		if(hist->GetYaxis()->IsVariableBinSize() or hist->GetYaxis()->GetXmax() <= hist->GetYaxis()->GetXmin()) {
+			return false;
+		}
+	}
+	return true;
+
+}
+
+antok::NativeHistogram* antok::NativeHistogram::fromTemplate(const TH1* hist, unsigned int sparseThreshold) {
+
+	if(not canRepresent(hist)) {
+		return 0;
+	}
+	const TAxis* xAxis = hist->GetXaxis();
+	if(hist->GetDimension() == 1) {
+		return new antok::NativeHistogram(xAxis->GetNbins(), xAxis->GetXmin(), xAxis->GetXmax(), sparseThreshold);
+	}
+	const TAxis* yAxis = hist->GetYaxis();
+	return new antok::NativeHistogram(xAxis->GetNbins(), xAxis->GetXmin(), xAxis->GetXmax(),
+	                                  yAxis->GetNbins(), yAxis->GetXmin(), yAxis->GetXmax(),
+	                                  sparseThreshold);
+
+}
+
+bool antok::NativeHistogram::add(const antok::NativeHistogram& rhs) {
+
+	if(_nBinsX != rhs._nBinsX or _lowerBoundX != rhs._lowerBoundX or _upperBoundX != rhs._upperBoundX or
+	   _nBinsY != rhs._nBinsY or _lowerBoundY != rhs._lowerBoundY or _upperBoundY != rhs._upperBoundY)
+	{
+		std::cerr<<"Cannot add NativeHistograms with different binning."<<std::endl;
+		return false;
+	}
+	for(unsigned int bin = 0; bin < _nCells; ++bin) {
+		const double* rhsPage = rhs._pages[bin >> rhs._pageShift];
+		if(rhsPage and rhsPage[bin & rhs._pageMask] != 0.) {
+			double*& page = _pages[bin >> _pageShift];
+			if(not page) {
+				page = newPage();
+			}
+			page[bin & _pageMask] += rhsPage[bin & rhs._pageMask];
+		}
+	}
+	_entries += rhs._entries;
+	_sumW += rhs._sumW;
+	_sumWX += rhs._sumWX;
+	_sumWX2 += rhs._sumWX2;
+	_sumWY += rhs._sumWY;
+	_sumWY2 += rhs._sumWY2;
+	_sumWXY += rhs._sumWXY;
+	return true;
+
+}
+
+void antok::NativeHistogram::addTo(TH1* hist) const {
+
+	if(isEmpty()) {
+		return;
+	}
+	// get the statistics before touching the bins, as ROOT might recompute them from the bin contents
+	double stats[7] = { 0., 0., 0., 0., 0., 0., 0. };
+	hist->GetStats(stats);
+	double entries = hist->GetEntries();
+
+	TArrayD* sumw2 = (hist->GetSumw2N() > 0) ? hist->GetSumw2() : 0;
+	for(unsigned int page_i = 0; page_i < _pages.size(); ++page_i) {
+		const double* page = _pages[page_i];
+		if(not page) {
+			continue;
+		}
+		const unsigned int firstBin = page_i << _pageShift;
+		for(unsigned int i = 0; i <= _pageMask and firstBin + i < _nCells; ++i) {
+			if(page[i] != 0.) {
+				hist->AddBinContent(firstBin + i, page[i]);
+				if(sumw2) {
+					// unit weights, so the sum of squared weights equals the count
+					(*sumw2)[firstBin + i] += page[i];
+				}
+			}
+		}
+	}
+
+	stats[0] += _sumW;
+	stats[1] += _sumW;
+	stats[2] += _sumWX;
+	stats[3] += _sumWX2;
+	if(_nBinsY > 0) {
+		stats[4] += _sumWY;
+		stats[5] += _sumWY2;
+		stats[6] += _sumWXY;
+	}
+	hist->PutStats(stats);
+	hist->SetEntries(entries + _entries);
+
+}
+
+void antok::NativeHistogram::reset() {
+
+	// give the memory back, the pages are allocated again on the next fill
+	for(unsigned int i = 0; i < _pages.size(); ++i) {
+		delete [] _pages[i];
+		_pages[i] = 0;
+	}
+	_entries = 0.;
+	_sumW = 0.;
+	_sumWX = 0.;
+	_sumWX2 = 0.;
+	_sumWY = 0.;
+	_sumWY2 = 0.;
+	_sumWXY = 0.;
+
+}
@@ -0,0 +1,137 @@
+#ifndef ANTOK_NATIVE_HISTOGRAM_H
+#define ANTOK_NATIVE_HISTOGRAM_H
+
+#include<vector>
+
+class TH1;
+
+namespace antok {
+
+	// Counts for a histogram with uniform binning in one or two dimensions,
+	// stored with ROOT's bin layout (including under- and overflow bins).
+	// Filling is a multiplication and a truncation without any virtual
+	// calls, the counts are added to a TH1 with addTo().
+	//
+	// The counts are kept in pages which are only allocated when one of
+	// their bins is filled. Histograms with up to sparseThreshold bins use
+	// a single page, larger ones pages of __sparsePageSize bins, so that
+	// mostly empty 2D histograms only take memory for the filled regions.
+	class NativeHistogram {
+
+	  public:
+
+		NativeHistogram(int nBinsX, double lowerBoundX, double upperBoundX, unsigned int sparseThreshold);
+		NativeHistogram(int nBinsX, double lowerBoundX, double upperBoundX,
+		                int nBinsY, double lowerBoundY, double upperBoundY,
+		                unsigned int sparseThreshold);
+		~NativeHistogram();
+
+		// true if hist has uniform binning in at most two dimensions
+		static bool canRepresent(const TH1* hist);
+		static NativeHistogram* fromTemplate(const TH1* hist, unsigned int sparseThreshold);
+
+		inline void fill(double x);
+		inline void fill(double x, double y);
+
+		bool add(const NativeHistogram& rhs);
+		void addTo(TH1* hist) const;
+		void reset();
+
+		bool isEmpty() const { return _entries == 0.; }
+
+	  private:
+
+		static const unsigned int __sparsePageShift = 12;
+		static const unsigned int __sparsePageSize = 1 << __sparsePageShift;
+
+		NativeHistogram(const NativeHistogram&);
+		NativeHistogram& operator=(const NativeHistogram&);
+
+		void initializePages(unsigned int sparseThreshold);
+		double* newPage() const;
+		inline void addToBin(unsigned int bin);
+
+		inline int findBin(double value, double lowerBound, double upperBound, int nBins) const;
+
+		int _nBinsX;
+		double _lowerBoundX;
+		double _upperBoundX;
+
+		int _nBinsY;
+		double _lowerBoundY;
+		double _upperBoundY;
+
+		unsigned int _nCells;
+		unsigned int _pageShift;
+		unsigned int _pageMask;
+		std::vector<double*> _pages;
+
+		double _entries;
+		double _sumW;
+		double _sumWX;
+		double _sumWX2;
+		double _sumWY;
+		double _sumWY2;
+		double _sumWXY;
+
+	};
+
+}
+
+inline int antok::NativeHistogram::findBin(double value,
+                                           double lowerBound,
+                                           double upperBound,
+                                           int nBins) const
+{
+	// same conventions as TAxis::FindFixBin, NaN ends up in the overflow bin
+	if(value < lowerBound) {
+		return 0;
+	}
+	if(not (value < upperBound)) {
+		return nBins + 1;
+	}
+	int bin = 1 + (int)(nBins * (value - lowerBound) / (upperBound - lowerBound));
+	return (bin > nBins) ? nBins : bin;
+}
+
+inline void antok::NativeHistogram::addToBin(unsigned int bin) {
+
+	double*& page = _pages[bin >> _pageShift];
+	if(not page) {
+		page = newPage();
+	}
+	page[bin & _pageMask] += 1.;
+
+}
+
+inline void antok::NativeHistogram::fill(double x) {
+
+	int bin = findBin(x, _lowerBoundX, _upperBoundX, _nBinsX);
+	addToBin(bin);
+	_entries += 1.;
+	if(bin > 0 and bin <= _nBinsX) {
+		_sumW += 1.;
+		_sumWX += x;
+		_sumWX2 += x*x;
+	}
+
+}
+
+inline void antok::NativeHistogram::fill(double x, double y) {
+
+	int binX = findBin(x, _lowerBoundX, _upperBoundX, _nBinsX);
+	int binY = findBin(y, _lowerBoundY, _upperBoundY, _nBinsY);
+	addToBin(binX + (_nBinsX + 2) * binY);
+	_entries += 1.;
+	if(binX > 0 and binX <= _nBinsX and binY > 0 and binY <= _nBinsY) {
+		_sumW += 1.;
+		_sumWX += x;
+		_sumWX2 += x*x;
+		_sumWY += y;
+		_sumWY2 += y*y;
+		_sumWXY += x*y;
+	}
+
+}
+
+#endif
@@ -1,19 +1,44 @@
 #include<object_manager.h>
 
+#include<algorithm>
 #include<assert.h>
 #include<iostream>
+#include<set>
 #include<sstream>
 
 #include<TFile.h>
 #include<TH1.h>
+#include<THnBase.h>
+#include<TNamed.h>
 #include<TObject.h>
+#include<TParameter.h>
+#include<TTree.h>
 
+#include<branch_widener.h>
 #include<cutter.h>
 #include<event.h>
+#include<output_options.h>
+#include<plot.hpp>
 #include<plotter.h>
 
 antok::ObjectManager* antok::ObjectManager::_objectManager = 0;
 
+namespace {
+
+	void __scaleHistogram(TObject* object, double factor) {
+		TH1* hist = dynamic_cast<TH1*>(object);
+		if(hist) {
+			hist->Scale(factor);
+			return;
+		}
+		THnBase* sparseHist = dynamic_cast<THnBase*>(object);
+		if(sparseHist) {
+			sparseHist->Scale(factor);
+		}
+	}
+
+}
+
 antok::ObjectManager* antok::ObjectManager::instance() {
 
 	if(_objectManager == 0) {
@@ -31,6 +56,11 @@ antok::ObjectManager::ObjectManager()
 	  _inFile(0),
 	  _outFile(0),
 	  _inTree(0),
+	  _branchWidener(0),
+	  _previewClusterPrescale(1),
+	  _previewClusterOffset(0),
+	  _previewDisabled(false),
+	  _entryRangesTree(0),
 	  _histNameAppendix("")
 {
 
@@ -45,6 +75,69 @@ bool antok::ObjectManager::magic() {
 
 }
 
+bool antok::ObjectManager::processEntry(Long64_t entry) {
+
+	// a quantity cache being written needs every entry calculated
+	if(not _cutter->cutPatternsFromCache() or _event->writesQuantityCache()) {
+		readEntry(entry);
+		return magic();
+	}
+
+	// The cut pattern comes from the sidecar, so the entry only has to be
+	// read and calculated if a plot, an output tree or the weighted cut flow wants it.
+	// Without output trees, the Initializer switched off the branches and functions no plot needs.
+	if(not _cutter->cut()) {
+		return false;
+	}
+	long cutPattern = _cutter->getCutPattern();
+	bool success = true;
+	if(_plotter->cutPatternUsed(cutPattern) or _cutter->cutPatternPertinent(cutPattern) or _plotter->hasWeightedWaterfall()) {
+		readEntry(entry);
+		success = _event->update() and _cutter->fillOutTrees();
+	}
+	_plotter->fill(cutPattern);
+	return success;
+
+}
+
+void antok::ObjectManager::readEntry(Long64_t entry) {
+
+	_inTree->GetEntry(entry);
+	if(_branchWidener) {
+		_branchWidener->widen();
+	}
+
+}
+
+const std::vector<std::pair<Long64_t, Long64_t> >& antok::ObjectManager::getEntryRanges() {
+
+	if(_entryRangesTree == _inTree) {
+		return _entryRanges;
+	}
+	_entryRangesTree = _inTree;
+	_entryRanges.clear();
+	const Long64_t nEntries = _inTree->GetEntries();
+	if(not isPreview()) {
+		_entryRanges.push_back(std::pair<Long64_t, Long64_t>(0, nEntries));
+		return _entryRanges;
+	}
+	// whole clusters keep the reading sequential
+	TTree::TClusterIterator cluster_it = _inTree->GetClusterIterator(0);
+	Long64_t nSelected = 0;
+	unsigned int cluster_i = 0;
+	for(Long64_t start = cluster_it(); start < nEntries; start = cluster_it(), ++cluster_i) {
+		if(cluster_i % _previewClusterPrescale != _previewClusterOffset) {
+			continue;
+		}
+		const Long64_t end = std::min(cluster_it.GetNextEntry(), nEntries);
+		_entryRanges.push_back(std::pair<Long64_t, Long64_t>(start, end));
+		nSelected += end - start;
+	}
+	std::cout<<"Preview: processing "<<nSelected<<" of "<<nEntries<<" entries in "<<_entryRanges.size()<<" of "<<cluster_i<<" clusters."<<std::endl;
+	return _entryRanges;
+
+}
+
 antok::Cutter& antok::ObjectManager::getCutter() {
 
 	if(_cutter == 0) {
@@ -115,7 +208,7 @@ bool antok::ObjectManager::registerObjectToWrite(TDirectory* path, TObject* obje
 
 }
 
-bool antok::ObjectManager::registerHistogramToCopy(TH1* histogram,
+bool antok::ObjectManager::registerHistogramToCopy(TNamed* histogram,
                                                    std::string path,
                                                    std::string newName,
                                                    std::string newTitle)
@@ -125,6 +218,21 @@ bool antok::ObjectManager::registerHistogramToCopy(TH1* histogram,
 	return true;
 }
 
+bool antok::ObjectManager::registerDeferredHistogram(antok::Plot* plot,
+                                                     unsigned int index,
+                                                     int slot,
+                                                     std::string path,
+                                                     std::string newName,
+                                                     std::string newTitle)
+{
+	histogramCopyInformation histCopyInfo(0, newName, newTitle);
+	histCopyInfo.plot = plot;
+	histCopyInfo.index = index;
+	histCopyInfo.slot = slot;
+	_histogramsToCopy[path].push_back(histCopyInfo);
+	return true;
+}
+
 bool antok::ObjectManager::registerHistogramNameAppendix(const std::string& appendix) {
 	_histNameAppendix = appendix;
 	return true;
@@ -132,11 +240,50 @@ bool antok::ObjectManager::registerHistogramNameAppendix(const std::string& appe
 
 bool antok::ObjectManager::finish() {
 
-	bool success = true;
+	bool success = _cutter->finish();
+	success = _event->finish() and success;
+	_plotter->flush();
+	_plotter->registerHistograms();
+	success = _plotter->writeSummaries() and success;
+
+	// a preview's histograms and cut flows are scaled up to the whole input while they are written
+	double previewScale = 1.;
+	Long64_t nPreviewEntries = 0;
+	const Long64_t nEntries = _inTree->GetEntries();
+	std::set<TObject*> histogramsToScale;
+	if(isPreview()) {
+		const std::vector<std::pair<Long64_t, Long64_t> >& entryRanges = getEntryRanges();
+		for(unsigned int i = 0; i < entryRanges.size(); ++i) {
+			nPreviewEntries += entryRanges[i].second - entryRanges[i].first;
+		}
+		if(nPreviewEntries > 0) {
+			previewScale = (double)nEntries / (double)nPreviewEntries;
+		}
+		for(std::map<TObject*, TDirectory*>::const_iterator it = _objectsToWrite.begin(); it != _objectsToWrite.end(); ++it) {
+			if(not _plotter->isWaterfallHistogram(it->first)) {
+				histogramsToScale.insert(it->first);
+			}
+		}
+		for(std::map<std::string, std::vector<histogramCopyInformation> >::const_iterator it = _histogramsToCopy.begin(); it != _histogramsToCopy.end(); ++it) {
+			for(unsigned int i = 0; i < it->second.size(); ++i) {
+				if(it->second[i].histogram) {
+					histogramsToScale.insert(it->second[i].histogram);
+				}
+			}
+		}
+		for(std::set<TObject*>::const_iterator it = histogramsToScale.begin(); it != histogramsToScale.end(); ++it) {
+			__scaleHistogram(*it, previewScale);
+		}
+		_plotter->scaleWaterfallHistograms(previewScale);
+	}
 
 	for(std::map<TObject*, TDirectory*>::const_iterator it = _objectsToWrite.begin(); it != _objectsToWrite.end(); ++it) {
 		it->second->cd();
 		it->first->Write();
+		TTree* tree = dynamic_cast<TTree*>(it->first);
+		if(tree) {
+			antok::OutputOptions::reportTreeSize(tree, std::string(it->second->GetName()) + "/" + tree->GetName());
+		}
 	}
 
 	for(std::map<std::string, std::vector<histogramCopyInformation> >::const_iterator histsToCopy_it = _histogramsToCopy.begin();
@@ -166,18 +313,42 @@ bool antok::ObjectManager::finish() {
 					strStr<<histName<<_histNameAppendix;
 					histName = strStr.str();
 			}
-			TH1* copiedHist = dynamic_cast<TH1*>(info.histogram->Clone(histName.c_str()));
-			assert(copiedHist != 0);
-			copiedHist->SetTitle(info.newTitle.c_str());
-			copiedHist->Write();
+			TNamed* histogram = info.histogram;
+			if(info.plot) {
+				histogram = info.plot->createDeferredHistogram(info.index, info.slot);
+				assert(histogram != 0);
+				if(isPreview()) {
+					__scaleHistogram(histogram, previewScale);
+				}
+			}
+			// histograms shared by several cut trains are written once per train under different names
+			histogram->SetName(histName.c_str());
+			histogram->SetTitle(info.newTitle.c_str());
+			histogram->Write();
+			if(info.plot) {
+				delete histogram;
+			}
 		}
 		dir->Close();
 	}
 	_outFile->cd();
-	_outFile->Delete("tmptmptmp;*");
+
+	if(isPreview()) {
+		TParameter<Long64_t>("previewClusterPrescale", _previewClusterPrescale).Write();
+		TParameter<Long64_t>("previewClusterOffset", _previewClusterOffset).Write();
+		TParameter<Long64_t>("previewEntries", nPreviewEntries).Write();
+		TParameter<Long64_t>("previewTotalEntries", nEntries).Write();
+		TParameter<double>("previewScale", previewScale).Write();
+		// back to counts, the histograms might be filled further after switching files
+		for(std::set<TObject*>::const_iterator it = histogramsToScale.begin(); it != histogramsToScale.end(); ++it) {
+			__scaleHistogram(*it, 1. / previewScale);
+		}
+		_plotter->scaleWaterfallHistograms(1. / previewScale);
+	}
 
 	_outFile->Close();
 	_inFile->Close();
+	_entryRangesTree = 0;
 	return success;
 
 }
@@ -3,19 +3,24 @@
 
 #include<map>
 #include<string>
+#include<utility>
 #include<vector>
 
+#include<Rtypes.h>
+
 class TDirectory;
 class TFile;
-class TH1;
+class TNamed;
 class TObject;
 class TTree;
 
 namespace antok {
 
+	class BranchWidener;
 	class Cutter;
 	class Data;
 	class Event;
+	class Plot;
 	class Plotter;
 
 	class ObjectManager {
@@ -27,6 +32,14 @@ namespace antok {
 		static ObjectManager* instance();
 
 		bool magic();
+		bool processEntry(Long64_t entry);
+
+		// [first, last) entries of the input tree to process, in preview mode
+		// only every k-th cluster
+		const std::vector<std::pair<Long64_t, Long64_t> >& getEntryRanges();
+		bool isPreview() const { return _previewClusterPrescale > 1; }
+		// a "Preview" in the config is then ignored, has to be called before the initialization
+		void disablePreview() { _previewDisabled = true; }
 
 		antok::Cutter& getCutter();
 		antok::Data& getData();
@@ -41,10 +54,18 @@ namespace antok {
 		bool setOutFile(TFile* outFile);
 
 		bool registerObjectToWrite(TDirectory* path, TObject* object);
-		bool registerHistogramToCopy(TH1* histogram,
+		bool registerHistogramToCopy(TNamed* histogram,
 		                             std::string path,
 		                             std::string newName,
 		                             std::string newTitle);
+		// the histogram is only created by the plot while it is written and deleted afterwards,
+		// for histograms which would be too large to keep all at once
+		bool registerDeferredHistogram(antok::Plot* plot,
+		                               unsigned int index,
+		                               int slot,
+		                               std::string path,
+		                               std::string newName,
+		                               std::string newTitle);
 		bool registerHistogramNameAppendix(const std::string& appendix);
 
 		bool finish();
@@ -52,19 +73,28 @@ namespace antok {
 	  private:
 
 		struct histogramCopyInformation {
-			TH1* histogram;
+			TNamed* histogram;
 			std::string newName;
 			std::string newTitle;
-			histogramCopyInformation(TH1* hist,
+			// set instead of histogram for deferred histograms
+			antok::Plot* plot;
+			unsigned int index;
+			int slot;
+			histogramCopyInformation(TNamed* hist,
 			                         std::string nName,
 			                         std::string nTitle)
 				: histogram(hist),
 				  newName(nName),
-				  newTitle(nTitle) { };
+				  newTitle(nTitle),
+				  plot(0),
+				  index(0),
+				  slot(-1) { };
 		};
 
 		ObjectManager();
 
+		void readEntry(Long64_t entry);
+
 		static ObjectManager* _objectManager;
 
 		antok::Cutter* _cutter;
@@ -75,6 +105,15 @@ namespace antok {
 		TFile* _inFile;
 		TFile* _outFile;
 		TTree* _inTree;
+		// compact input branches, 0 if there are none
+		antok::BranchWidener* _branchWidener;
+
+		unsigned int _previewClusterPrescale;
+		unsigned int _previewClusterOffset;
+		bool _previewDisabled;
+		TTree* _entryRangesTree;
+		std::vector<std::pair<Long64_t, Long64_t> > _entryRanges;
+
 		std::map<TObject*, TDirectory*> _objectsToWrite;
 		std::map<std::string, std::vector<histogramCopyInformation> > _histogramsToCopy;
 		std::string _histNameAppendix;
@@ -0,0 +1,212 @@
+#include<output_options.h>
+
+#include<iomanip>
+#include<iostream>
+#include<sstream>
+
+#include<yaml-cpp/yaml.h>
+
+#include<RVersion.h>
+#include<TBranch.h>
+#include<TFile.h>
+#include<TObjArray.h>
+#include<TTree.h>
+
+#include<yaml_utils.hpp>
+
+bool antok::OutputOptions::read(const YAML::Node& optionNode) {
+
+	using antok::YAMLUtils::hasNodeKey;
+
+	if(hasNodeKey(optionNode, "CompressionAlgorithm")) {
+		std::string algorithm = antok::YAMLUtils::getString(optionNode["CompressionAlgorithm"]);
+		if(algorithm == "ZLIB") {
+			compressionAlgorithm = 1;
+		} else if(algorithm == "LZMA") {
+			compressionAlgorithm = 2;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,10,0)
+		} else if(algorithm == "LZ4") {
+			compressionAlgorithm = 4;
+#endif
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,20,0)
+		} else if(algorithm == "ZSTD") {
+			compressionAlgorithm = 5;
+#endif
+		} else {
+			std::cerr<<"Entry \"CompressionAlgorithm\" in \"OutputOptions\" has to be one of \"ZLIB\", \"LZMA\"";
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,10,0)
+			std::cerr<<", \"LZ4\"";
+#endif
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,20,0)
+			std::cerr<<", \"ZSTD\"";
+#endif
+			std::cerr<<" (found \""<<algorithm<<"\")."<<std::endl;
+			return false;
+		}
+	}
+	if(hasNodeKey(optionNode, "CompressionLevel")) {
+		if(not antok::YAMLUtils::getValue<int>(optionNode["CompressionLevel"], &compressionLevel) or
+		   compressionLevel < 0 or compressionLevel > 9)
+		{
+			std::cerr<<"Entry \"CompressionLevel\" in \"OutputOptions\" has to be an integer in [0, 9]."<<std::endl;
+			return false;
+		}
+	}
+	if(hasNodeKey(optionNode, "BasketSize")) {
+		if(not antok::YAMLUtils::getValue<int>(optionNode["BasketSize"], &basketSize) or basketSize <= 0) {
+			std::cerr<<"Entry \"BasketSize\" in \"OutputOptions\" has to be a positive number of bytes."<<std::endl;
+			return false;
+		}
+	}
+	if(hasNodeKey(optionNode, "AutoFlush")) {
+		if(not antok::YAMLUtils::getValue<Long64_t>(optionNode["AutoFlush"], &autoFlush) or autoFlush == 0) {
+			std::cerr<<"Entry \"AutoFlush\" in \"OutputOptions\" has to be a number of entries (> 0) or of bytes (< 0)."<<std::endl;
+			return false;
+		}
+	}
+	if(hasNodeKey(optionNode, "BranchPrecision")) {
+		const YAML::Node& precisionNodes = optionNode["BranchPrecision"];
+		if(not precisionNodes.IsSequence()) {
+			std::cerr<<"Entry \"BranchPrecision\" in \"OutputOptions\" has to be a list."<<std::endl;
+			return false;
+		}
+		for(YAML::const_iterator precision_it = precisionNodes.begin(); precision_it != precisionNodes.end(); ++precision_it) {
+			const YAML::Node& precisionNode = *precision_it;
+			branchPrecision precision;
+			precision.name = antok::YAMLUtils::getString(precisionNode["Name"]);
+			if(precision.name == "") {
+				std::cerr<<"Could not convert \"Name\" of one of the \"BranchPrecision\" entries to std::string."<<std::endl;
+				return false;
+			}
+			for(unsigned int i = 0; i < branchPrecisions.size(); ++i) {
+				if(branchPrecisions[i].name == precision.name) {
+					std::cerr<<"Branch \""<<precision.name<<"\" appears twice in \"BranchPrecision\"."<<std::endl;
+					return false;
+				}
+			}
+			std::string storage = antok::YAMLUtils::getString(precisionNode["Storage"]);
+			if(storage == "float") {
+				precision.storage = branchPrecision::FLOAT;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,22,0)
+			} else if(storage == "Float16_t") {
+				precision.storage = branchPrecision::FLOAT16;
+#endif
+			} else if(storage == "double") {
+				precision.storage = branchPrecision::DOUBLE;
+			} else {
+				std::cerr<<"Entry \"Storage\" of branch \""<<precision.name<<"\" in \"BranchPrecision\" has to be one of \"float\", ";
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,22,0)
+				std::cerr<<"\"Float16_t\", ";
+#endif
+				std::cerr<<"\"double\" (found \""<<storage<<"\")."<<std::endl;
+				return false;
+			}
+			if(hasNodeKey(precisionNode, "Range")) {
+				const YAML::Node& rangeNode = precisionNode["Range"];
+				if(precision.storage != branchPrecision::FLOAT16) {
+					std::cerr<<"A \"Range\" can only be given for \"Float16_t\" storage (branch \""<<precision.name<<"\")."<<std::endl;
+					return false;
+				}
+				if(not rangeNode.IsSequence() or rangeNode.size() != 3 or
+				   not antok::YAMLUtils::getValue<double>(rangeNode[0], &precision.rangeMin) or
+				   not antok::YAMLUtils::getValue<double>(rangeNode[1], &precision.rangeMax) or
+				   not antok::YAMLUtils::getValue<int>(rangeNode[2], &precision.rangeBits) or
+				   precision.rangeMin >= precision.rangeMax or precision.rangeBits < 2 or precision.rangeBits > 32)
+				{
+					std::cerr<<"Entry \"Range\" of branch \""<<precision.name<<"\" in \"BranchPrecision\" has to be [min, max, bits] with min < max and 2 <= bits <= 32."<<std::endl;
+					return false;
+				}
+			}
+			if(hasNodeKey(precisionNode, "MantissaBits")) {
+				const int maxMantissaBits = (precision.storage == branchPrecision::DOUBLE) ? 52 : 23;
+				if(precision.storage == branchPrecision::FLOAT16) {
+					std::cerr<<"\"MantissaBits\" cannot be given for \"Float16_t\" storage (branch \""<<precision.name<<"\")."<<std::endl;
+					return false;
+				}
+				if(not antok::YAMLUtils::getValue<int>(precisionNode["MantissaBits"], &precision.mantissaBits) or
+				   precision.mantissaBits < 1 or precision.mantissaBits > maxMantissaBits)
+				{
+					std::cerr<<"Entry \"MantissaBits\" of branch \""<<precision.name<<"\" in \"BranchPrecision\" has to be an integer in [1, "<<maxMantissaBits<<"]."<<std::endl;
+					return false;
+				}
+			}
+			if(precision.storage == branchPrecision::DOUBLE and precision.mantissaBits < 0) {
+				std::cerr<<"\"double\" storage of branch \""<<precision.name<<"\" in \"BranchPrecision\" needs \"MantissaBits\"."<<std::endl;
+				return false;
+			}
+			branchPrecisions.push_back(precision);
+		}
+	}
+	return true;
+
+}
+
+void antok::OutputOptions::applyToFile(TFile* file) const {
+
+	if(compressionAlgorithm >= 0) {
+		file->SetCompressionAlgorithm(compressionAlgorithm);
+	}
+	if(compressionLevel >= 0) {
+		file->SetCompressionLevel(compressionLevel);
+	}
+
+}
+
+void antok::OutputOptions::applyToTree(TTree* tree) const {
+
+	if(compressionAlgorithm >= 0 or compressionLevel >= 0) {
+		// cloned branches keep the compression of the input tree otherwise
+		TFile* file = tree->GetCurrentFile();
+		if(file) {
+			TObjArray* branches = tree->GetListOfBranches();
+			for(int i = 0; i < branches->GetEntriesFast(); ++i) {
+				TBranch* branch = dynamic_cast<TBranch*>(branches->UncheckedAt(i));
+				if(branch) {
+					branch->SetCompressionSettings(file->GetCompressionSettings());
+				}
+			}
+		}
+	}
+	if(basketSize > 0) {
+		tree->SetBasketSize("*", basketSize);
+	}
+	if(autoFlush != 0) {
+		tree->SetAutoFlush(autoFlush);
+	}
+
+}
+
+TTree* antok::OutputOptions::cloneTree(TTree* inTree) const {
+
+	std::vector<std::string> disabledBranches;
+	for(unsigned int i = 0; i < branchPrecisions.size(); ++i) {
+		const char* name = branchPrecisions[i].name.c_str();
+		if(inTree->GetBranch(name) and inTree->GetBranchStatus(name)) {
+			inTree->SetBranchStatus(name, false);
+			disabledBranches.push_back(branchPrecisions[i].name);
+		}
+	}
+	TTree* outTree = inTree->CloneTree(0);
+	for(unsigned int i = 0; i < disabledBranches.size(); ++i) {
+		inTree->SetBranchStatus(disabledBranches[i].c_str(), true);
+	}
+	return outTree;
+
+}
+
+void antok::OutputOptions::reportTreeSize(TTree* tree, const std::string& label) {
+
+	const double totBytes = tree->GetTotBytes();
+	const double zipBytes = tree->GetZipBytes();
+	std::stringstream strStr;
+	strStr<<std::fixed<<std::setprecision(2);
+	strStr<<"Tree \""<<label<<"\": "<<tree->GetEntries()<<" entries, "
+	      <<totBytes / (1024. * 1024.)<<" MB uncompressed, "
+	      <<zipBytes / (1024. * 1024.)<<" MB compressed";
+	if(zipBytes > 0.) {
+		strStr<<" (factor "<<totBytes / zipBytes<<")";
+	}
+	strStr<<".";
+	std::cout<<strStr.str()<<std::endl;
+
+}
@@ -0,0 +1,82 @@
+#ifndef ANTOK_OUTPUT_OPTIONS_H
+#define ANTOK_OUTPUT_OPTIONS_H
+
+#include<string>
+#include<vector>
+
+#include<Rtypes.h>
+
+class TFile;
+class TTree;
+
+namespace YAML {
+	class Node;
+}
+
+namespace antok {
+
+	// Compression and basket layout of the files and trees antok writes, as
+	// given in the "OutputOptions" of the config file. Everything which is
+	// not set is left at ROOT's defaults.
+	struct OutputOptions {
+
+		// storage of a double or std::vector<double> branch of the output trees
+		// with fewer bits, the conversion is done by the TreeWriter
+		struct branchPrecision {
+
+			enum storageType {
+				FLOAT,
+				FLOAT16,
+				DOUBLE
+			};
+
+			branchPrecision()
+				: name(""),
+				  storage(FLOAT),
+				  rangeMin(0.),
+				  rangeMax(0.),
+				  rangeBits(0),
+				  mantissaBits(-1) { };
+
+			std::string name;
+			storageType storage;
+			// Float16_t only, stored as rangeBits-bit integer in [rangeMin, rangeMax] if rangeBits > 0
+			double rangeMin;
+			double rangeMax;
+			int rangeBits;
+			// float and double only, the mantissa is rounded to this many bits before compression, -1 if not set
+			int mantissaBits;
+
+		};
+
+		OutputOptions()
+			: compressionAlgorithm(-1),
+			  compressionLevel(-1),
+			  basketSize(0),
+			  autoFlush(0) { };
+
+		bool read(const YAML::Node& optionNode);
+
+		// has to be called before the trees are created in the file
+		void applyToFile(TFile* file) const;
+		void applyToTree(TTree* tree) const;
+
+		// CloneTree(0) without the input branches which are stored with reduced precision
+		TTree* cloneTree(TTree* inTree) const;
+
+		// prints the entries and the uncompressed and compressed size of a written tree
+		static void reportTreeSize(TTree* tree, const std::string& label);
+
+		// ROOT's algorithm number (1 ZLIB, 2 LZMA, 4 LZ4, 5 ZSTD), -1 if not set
+		int compressionAlgorithm;
+		int compressionLevel;
+		int basketSize;
+		// > 0 entries, < 0 bytes per cluster, as in TTree::SetAutoFlush
+		Long64_t autoFlush;
+		std::vector<branchPrecision> branchPrecisions;
+
+	};
+
+}
+
+#endif
@@ -1,14 +1,36 @@
 #ifndef ANTOK_PLOT_HPP
 #define ANTOK_PLOT_HPP
 
+#include<vector>
+
+class TNamed;
+
 namespace antok {
 
+	namespace plotUtils {
+		struct eventWeights;
+	}
+
 	class Plot {
 
 	  public:
 
 		virtual ~Plot() { };
-		virtual void fill(long cutmask) = 0;
+		// matchedCutmasks holds the Plotter's indices of all cutmasks the current event passes
+		virtual void fill(const std::vector<unsigned int>& matchedCutmasks) = 0;
+		// write buffered values to the histograms, called before they are saved;
+		// different plots may be flushed in parallel
+		virtual void flush() { };
+		// hand the histograms to the ObjectManager, called after flush()
+		virtual void registerHistograms() { };
+		// a new histogram for one registered with ObjectManager::registerDeferredHistogram,
+		// slot -1 for the unweighted one, deleted by the caller once it is written
+		virtual TNamed* createDeferredHistogram(unsigned int index, int slot) { return 0; };
+		// additionally fill one histogram per event weight, false if the plot cannot do that
+		virtual bool setEventWeights(const antok::plotUtils::eventWeights* weights) { return false; };
+		// called after the histograms were written when the next output file follows,
+		// the histograms start empty again unless accumulate is set
+		virtual void resetForNextOutput(bool accumulate) { };
 
 	};
 
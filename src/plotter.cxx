@@ -1,12 +1,24 @@
 #include<plotter.h>
 
+#include<algorithm>
+#include<fstream>
+#include<iomanip>
+#include<sstream>
+
 #include<yaml-cpp/yaml.h>
 
+#include<RVersion.h>
+#include<TArrayD.h>
+#include<TFile.h>
 #include<TH1.h>
+#include<TRandom3.h>
+#include<TROOT.h>
+#include<TThread.h>
 
 #include<cutter.h>
 #include<object_manager.h>
 #include<plot.hpp>
+#include<summary_plot.h>
 #include<yaml_utils.hpp>
 
 antok::Plotter* antok::Plotter::_plotter = 0;
@@ -20,23 +32,302 @@ antok::Plotter* antok::Plotter::instance() {
 
 void antok::Plotter::fill(long cutPattern) {
 
-	for(unsigned int i = 0; i < _plots.size(); ++i) {
-		_plots[i]->fill(cutPattern);
+	_matchedCutmasks.clear();
+	for(unsigned int i = 0; i < _cutmasks.size(); ++i) {
+		if((_cutmasks[i]&cutPattern) == _cutmasks[i]) {
+			_matchedCutmasks.push_back(i);
+		}
+	}
+	if(not _matchedCutmasks.empty()) {
+		if(_eventWeights.getNWeights()) {
+			_eventWeights.update();
+		}
+		for(unsigned int i = 0; i < _plots.size(); ++i) {
+			_plots[i]->fill(_matchedCutmasks);
+		}
 	}
 	for(unsigned int i = 0; i < _waterfallHistograms.size(); ++i) {
-		TH1* hist = _waterfallHistograms[i].histogram;
-		for(unsigned int j = 0; j < _waterfallHistograms[i].cuts.size(); ++j) {
-			const bool* result = _waterfallHistograms[i].cuts[j].second;
-			if(*result) {
-				hist->Fill(_waterfallHistograms[i].cuts[j].first, 1);
+		_waterfallHistograms[i].fill();
+	}
+
+}
+
+void antok::Plotter::flush() {
+
+	for(unsigned int i = 0; i < _waterfallHistograms.size(); ++i) {
+		_waterfallHistograms[i].flush();
+	}
+
+	unsigned int nThreads = std::min(_finishThreads, (unsigned int)_plots.size());
+	if(nThreads <= 1) {
+		for(unsigned int i = 0; i < _plots.size(); ++i) {
+			_plots[i]->flush();
+		}
+		return;
+	}
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+	ROOT::EnableThreadSafety();
+#else
+	TThread::Initialize();
+#endif
+	std::vector<flushThreadArguments> arguments(nThreads);
+	std::vector<TThread*> threads(nThreads, 0);
+	for(unsigned int i = 0; i < nThreads; ++i) {
+		arguments[i].plotter = this;
+		arguments[i].threadIndex = i;
+		arguments[i].nThreads = nThreads;
+		threads[i] = new TThread("antokPlotFlush", (TThread::VoidRtnFunc_t)&antok::Plotter::__flushThread, (void*)&arguments[i]);
+		threads[i]->Run();
+	}
+	for(unsigned int i = 0; i < nThreads; ++i) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+
+}
+
+void* antok::Plotter::__flushThread(void* arg) {
+
+	const flushThreadArguments* arguments = (const flushThreadArguments*)arg;
+	const std::vector<antok::Plot*>& plots = arguments->plotter->_plots;
+	for(unsigned int i = arguments->threadIndex; i < plots.size(); i += arguments->nThreads) {
+		plots[i]->flush();
+	}
+	return 0;
+
+}
+
+void antok::Plotter::registerHistograms() {
+
+	for(unsigned int i = 0; i < _plots.size(); ++i) {
+		_plots[i]->registerHistograms();
+	}
+
+}
+
+namespace {
+
+	std::string __jsonString(const std::string& str) {
+
+		std::stringstream strStr;
+		strStr<<'"';
+		for(unsigned int i = 0; i < str.size(); ++i) {
+			const char c = str[i];
+			if(c == '"' or c == '\\') {
+				strStr<<'\\'<<c;
+			} else if((unsigned char)c < 0x20) {
+				strStr<<"\\u"<<std::hex<<std::setw(4)<<std::setfill('0')<<(int)c<<std::dec;
 			} else {
-				break;
+				strStr<<c;
 			}
 		}
+		strStr<<'"';
+		return strStr.str();
+
+	}
+
+	std::string __jsonNumber(double value) {
+
+		// NaN and inf are not valid JSON
+		if(value != value or value - value != 0.) {
+			return "null";
+		}
+		std::stringstream strStr;
+		strStr<<std::setprecision(12)<<value;
+		return strStr.str();
+
 	}
 
 }
 
+void antok::Plotter::scaleWaterfallHistograms(double factor) {
+
+	for(unsigned int i = 0; i < _waterfallHistograms.size(); ++i) {
+		_waterfallHistograms[i].scale(factor);
+	}
+
+}
+
+bool antok::Plotter::isWaterfallHistogram(const TObject* object) const {
+
+	for(unsigned int i = 0; i < _waterfallHistograms.size(); ++i) {
+		if(_waterfallHistograms[i].histogram == object) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
+bool antok::Plotter::hasWeightedWaterfall() const {
+
+	for(unsigned int i = 0; i < _waterfallHistograms.size(); ++i) {
+		if(_waterfallHistograms[i].weight) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
+bool antok::Plotter::resetForNextOutput(bool accumulate) {
+
+	std::set<std::pair<std::string, std::string> > plotDirectories;
+	plotDirectories.swap(_plotDirectories);
+	_cutTrainDirectories.clear();
+	bool success = true;
+	for(std::set<std::pair<std::string, std::string> >::const_iterator it = plotDirectories.begin(); it != plotDirectories.end(); ++it) {
+		success = makePlotDirectory(it->first, it->second) and success;
+	}
+	for(unsigned int i = 0; i < _waterfallHistograms.size() and not accumulate; ++i) {
+		// keeps the cut labels
+		_waterfallHistograms[i].histogram->Reset("ICES");
+	}
+	if(_eventWeights.random and not accumulate) {
+		// every output gets the same replicas as in a run of its own
+		_eventWeights.random->SetSeed(_eventWeights.poissonSeed);
+	}
+	for(unsigned int i = 0; i < _plots.size(); ++i) {
+		_plots[i]->resetForNextOutput(accumulate);
+	}
+	return success;
+
+}
+
+bool antok::Plotter::writeSummaries() {
+
+	if(_summaries.empty()) {
+		return true;
+	}
+	std::vector<antok::plotUtils::summaryResult> results;
+	for(unsigned int i = 0; i < _summaries.size(); ++i) {
+		_summaries[i]->getResults(results, _writeEmptyHistograms);
+	}
+
+	TFile* outFile = antok::ObjectManager::instance()->getOutFile();
+	outFile->cd();
+	antok::SummaryPlot::writeTree(results);
+
+	if(_summaryJsonFileName == "") {
+		return true;
+	}
+	std::ofstream jsonFile(_summaryJsonFileName.c_str());
+	if(not jsonFile) {
+		std::cerr<<"Could not open \"JsonFile\" \""<<_summaryJsonFileName<<"\" of the \"Summaries\"."<<std::endl;
+		return false;
+	}
+	jsonFile<<"[";
+	for(unsigned int i = 0; i < results.size(); ++i) {
+		const antok::plotUtils::summaryResult& result = results[i];
+		jsonFile<<(i ? ",\n" : "\n");
+		jsonFile<<"  {\"variable\": "<<__jsonString(result.variable);
+		jsonFile<<", \"cutTrain\": "<<__jsonString(result.cutTrain);
+		jsonFile<<", \"name\": "<<__jsonString(result.name);
+		jsonFile<<", \"title\": "<<__jsonString(result.title);
+		jsonFile<<", \"entries\": "<<result.entries;
+		jsonFile<<", \"mean\": "<<__jsonNumber(result.mean);
+		jsonFile<<", \"rms\": "<<__jsonNumber(result.rms);
+		jsonFile<<", \"min\": "<<__jsonNumber(result.min);
+		jsonFile<<", \"max\": "<<__jsonNumber(result.max);
+		jsonFile<<", \"quantiles\": {";
+		for(unsigned int j = 0; j < result.quantiles.size(); ++j) {
+			jsonFile<<(j ? ", " : "")<<__jsonString(__jsonNumber(result.quantileLevels[j]))<<": "<<__jsonNumber(result.quantiles[j]);
+		}
+		jsonFile<<"}}";
+	}
+	jsonFile<<"\n]\n";
+	jsonFile.close();
+	if(not jsonFile) {
+		std::cerr<<"Could not write \"JsonFile\" \""<<_summaryJsonFileName<<"\" of the \"Summaries\"."<<std::endl;
+		return false;
+	}
+	return true;
+
+}
+
+antok::plotUtils::eventWeights::~eventWeights() {
+	delete random;
+}
+
+void antok::plotUtils::eventWeights::update() {
+
+	for(unsigned int i = 0; i < variables.size(); ++i) {
+		values[i] = *variables[i];
+	}
+	for(unsigned int i = variables.size(); i < values.size(); ++i) {
+		values[i] = random->Poisson(1.);
+	}
+
+}
+
+unsigned int antok::Plotter::registerCutmask(long cutmask) {
+
+	std::map<long, unsigned int>::const_iterator index_it = _cutmaskIndices.find(cutmask);
+	if(index_it != _cutmaskIndices.end()) {
+		return index_it->second;
+	}
+	unsigned int index = _cutmasks.size();
+	_cutmasks.push_back(cutmask);
+	_cutmaskIndices[cutmask] = index;
+	_matchedCutmasks.reserve(_cutmasks.size());
+	return index;
+
+}
+
+const std::pair<std::string, std::string>& antok::Plotter::getCutmaskLabels(const std::string& cutTrainName, long cutmask) {
+
+	const std::pair<std::string, long> key(cutTrainName, cutmask);
+	std::map<std::pair<std::string, long>, std::pair<std::string, std::string> >::const_iterator labels_it = _cutmaskLabels.find(key);
+	if(labels_it != _cutmaskLabels.end()) {
+		return labels_it->second;
+	}
+	antok::Cutter& cutter = antok::ObjectManager::instance()->getCutter();
+	const std::vector<antok::Cut*>& cuts = cutter.getCutsForCutTrain(cutTrainName);
+	std::string bits(cuts.size(), '0');
+	for(unsigned int i = 0; i < cuts.size(); ++i) {
+		if(cutter.cutOnInCutmask(cutmask, cuts[i])) {
+			bits[i] = '1';
+		}
+	}
+	std::pair<std::string, std::string>& labels = _cutmaskLabels[key];
+	labels.first = bits;
+	labels.second = cutter.getAbbreviations(cutmask, cutTrainName);
+	return labels;
+
+}
+
+bool antok::Plotter::makePlotDirectory(const std::string& cutTrainName, const std::string& plotName) {
+
+	if(not _plotDirectories.insert(std::pair<std::string, std::string>(cutTrainName, plotName)).second) {
+		return true;
+	}
+	TDirectory*& cutTrainDir = _cutTrainDirectories[cutTrainName];
+	if(cutTrainDir == 0) {
+		cutTrainDir = antok::ObjectManager::instance()->getOutFile()->GetDirectory(cutTrainName.c_str());
+		if(cutTrainDir == 0) {
+			std::cerr<<"Could not find directory of \"CutTrain\" \""<<cutTrainName<<"\" in the output file."<<std::endl;
+			return false;
+		}
+	}
+	if(not cutTrainDir->GetDirectory(plotName.c_str())) {
+		cutTrainDir->mkdir(plotName.c_str());
+	}
+	return true;
+
+}
+
+bool antok::Plotter::cutPatternUsed(long cutPattern) const {
+
+	for(unsigned int i = 0; i < _cutmasks.size(); ++i) {
+		if((_cutmasks[i]&cutPattern) == _cutmasks[i]) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
 namespace {
 
 	std::string __getCutnamesOffNode(const YAML::Node& withCut, const std::string& cutTrainName) {
@@ -152,6 +443,108 @@ bool antok::Plotter::handleAdditionalCuts(const YAML::Node& trainList, std::map<
 
 }
 
+void antok::plotUtils::getHistogramNameAndTitle(const std::string& plotName,
+                                                const std::string& plotTitle,
+                                                const std::string& cutTrainName,
+                                                long cutmask,
+                                                std::string& histName,
+                                                std::string& histTitle)
+{
+
+	const std::pair<std::string, std::string>& labels = antok::Plotter::instance()->getCutmaskLabels(cutTrainName, cutmask);
+	histName = plotName + "_" + labels.first;
+	histTitle = plotTitle + " " + labels.second;
+
+}
+
+bool antok::plotUtils::waterfallHistogramContainer::add(const antok::plotUtils::waterfallHistogramContainer& rhs) {
+
+	if(counts.size() != rhs.counts.size() or sumOfWeights.size() != rhs.sumOfWeights.size()) {
+		std::cerr<<"Cannot add cut flows with different numbers of cuts or weighting."<<std::endl;
+		return false;
+	}
+	for(unsigned int i = 0; i < counts.size(); ++i) {
+		counts[i] += rhs.counts[i];
+	}
+	for(unsigned int i = 0; i < sumOfWeights.size(); ++i) {
+		sumOfWeights[i] += rhs.sumOfWeights[i];
+		sumOfSquaredWeights[i] += rhs.sumOfSquaredWeights[i];
+	}
+	return true;
+
+}
+
+bool antok::plotUtils::waterfallHistogramContainer::addInputBins(const TH1* inputHistogram) {
+
+	if(inputHistogram->GetNbinsX() < startBin - 1) {
+		std::cerr<<"Input statistics histogram \""<<inputHistogram->GetName()<<"\" has too few bins."<<std::endl;
+		return false;
+	}
+	for(int bin = 1; bin < startBin; ++bin) {
+		if(std::string(inputHistogram->GetXaxis()->GetBinLabel(bin)) != histogram->GetXaxis()->GetBinLabel(bin)) {
+			std::cerr<<"Bin "<<bin<<" of the input statistics histogram \""<<inputHistogram->GetName()<<"\" has another label than in the first input file."<<std::endl;
+			return false;
+		}
+	}
+	TArrayD* sumw2 = (histogram->GetSumw2N() > 0) ? histogram->GetSumw2() : 0;
+	for(int bin = 1; bin < startBin; ++bin) {
+		histogram->AddBinContent(bin, inputHistogram->GetBinContent(bin));
+		if(sumw2) {
+			(*sumw2)[bin] += inputHistogram->GetBinError(bin) * inputHistogram->GetBinError(bin);
+		}
+	}
+	histogram->SetEntries(histogram->GetEntries() + inputHistogram->GetEntries());
+	return true;
+
+}
+
+void antok::plotUtils::waterfallHistogramContainer::flush() {
+
+	if(weight) {
+		if(histogram->GetSumw2N() == 0) {
+			histogram->Sumw2();
+		}
+		TArrayD* sumw2 = histogram->GetSumw2();
+		for(unsigned int i = 0; i < cuts.size(); ++i) {
+			histogram->AddBinContent(startBin + i, sumOfWeights[i]);
+			(*sumw2)[startBin + i] += sumOfSquaredWeights[i];
+			sumOfWeights[i] = 0.;
+			sumOfSquaredWeights[i] = 0.;
+		}
+	} else {
+		TArrayD* sumw2 = (histogram->GetSumw2N() > 0) ? histogram->GetSumw2() : 0;
+		for(unsigned int i = 0; i < cuts.size(); ++i) {
+			histogram->AddBinContent(startBin + i, counts[i]);
+			if(sumw2) {
+				(*sumw2)[startBin + i] += counts[i];
+			}
+		}
+	}
+	Long64_t entries = 0;
+	for(unsigned int i = 0; i < cuts.size(); ++i) {
+		entries += counts[i];
+		counts[i] = 0;
+	}
+	histogram->SetEntries(histogram->GetEntries() + entries);
+
+}
+
+void antok::plotUtils::waterfallHistogramContainer::scale(double factor) {
+
+	// SetBinContent() changes the number of entries
+	const double entries = histogram->GetEntries();
+	TArrayD* sumw2 = (histogram->GetSumw2N() > 0) ? histogram->GetSumw2() : 0;
+	for(unsigned int i = 0; i < cuts.size(); ++i) {
+		const int bin = startBin + i;
+		histogram->SetBinContent(bin, factor * histogram->GetBinContent(bin));
+		if(sumw2) {
+			(*sumw2)[bin] *= factor * factor;
+		}
+	}
+	histogram->SetEntries(entries);
+
+}
+
 antok::plotUtils::GlobalPlotOptions::GlobalPlotOptions(const YAML::Node& optionNode) {
 
 	using antok::YAMLUtils::hasNodeKey;
@@ -161,6 +554,12 @@ antok::plotUtils::GlobalPlotOptions::GlobalPlotOptions(const YAML::Node& optionN
 	plotsWithSingleCutsOff = false;
 	statisticsHistInName = "";
 	statisticsHistOutName = "";
+	statisticsHistWeightName = "";
+	writeEmptyHistograms = false;
+	sparseHistogramThreshold = 1 << 20;
+	finishThreads = 1;
+	poissonReplicas = 0;
+	poissonSeed = 4357;
 
 	if(not optionNode) {
 		std::cerr<<"Warning: \"GlobalPlotOptions\" not found in configuration file."<<std::endl;
@@ -171,6 +570,54 @@ antok::plotUtils::GlobalPlotOptions::GlobalPlotOptions(const YAML::Node& optionN
 	plotsWithSingleCutsOn = handleOnOffOption("PlotsWithSingleCutsOn", optionNode, "GobalPlotOptions");
 	plotsWithSingleCutsOff = handleOnOffOption("PlotsWithSingleCutsOff", optionNode, "GobalPlotOptions");
 
+	if(hasNodeKey(optionNode, "WriteEmptyHistograms")) {
+		writeEmptyHistograms = handleOnOffOption("WriteEmptyHistograms", optionNode, "GobalPlotOptions");
+	}
+
+	if(hasNodeKey(optionNode, "SparseHistogramThreshold")) {
+		try {
+			sparseHistogramThreshold = optionNode["SparseHistogramThreshold"].as<unsigned int>();
+		} catch(const YAML::TypedBadConversion<unsigned int>& e) {
+			std::cerr<<"Warning: \"SparseHistogramThreshold\" in \"GobalPlotOptions\" is not a number, using "<<sparseHistogramThreshold<<"."<<std::endl;
+		}
+	}
+
+	if(hasNodeKey(optionNode, "FinishThreads")) {
+		try {
+			finishThreads = optionNode["FinishThreads"].as<unsigned int>();
+		} catch(const YAML::TypedBadConversion<unsigned int>& e) {
+			std::cerr<<"Warning: \"FinishThreads\" in \"GobalPlotOptions\" is not a number, using one thread."<<std::endl;
+		}
+		if(finishThreads == 0) {
+			finishThreads = 1;
+		}
+	}
+
+	if(hasNodeKey(optionNode, "EventWeights")) {
+		const YAML::Node& weightsOpt = optionNode["EventWeights"];
+		if(hasNodeKey(weightsOpt, "Variables")) {
+			for(YAML::const_iterator weights_it = weightsOpt["Variables"].begin(); weights_it != weightsOpt["Variables"].end(); ++weights_it) {
+				std::string weightName = antok::YAMLUtils::getString(*weights_it);
+				if(weightName == "") {
+					std::cerr<<"Warning: Could not convert one of the \"Variables\" of the \"EventWeights\" to std::string, skipping it."<<std::endl;
+					continue;
+				}
+				eventWeightNames.push_back(weightName);
+			}
+		}
+		try {
+			if(hasNodeKey(weightsOpt, "PoissonReplicas")) {
+				poissonReplicas = weightsOpt["PoissonReplicas"].as<unsigned int>();
+			}
+			if(hasNodeKey(weightsOpt, "Seed")) {
+				poissonSeed = weightsOpt["Seed"].as<unsigned int>();
+			}
+		} catch(const YAML::TypedBadConversion<unsigned int>& e) {
+			std::cerr<<"Warning: \"PoissonReplicas\" or \"Seed\" of the \"EventWeights\" is not a number, not using replicas."<<std::endl;
+			poissonReplicas = 0;
+		}
+	}
+
 	if(not hasNodeKey(optionNode, "StatisticsHistogram")) {
 		std::cerr<<"Warning: \"StatisticsHistogram\" not found in \"GobalPlotOptions\", switching it off"<<std::endl;
 	} else {
@@ -187,6 +634,12 @@ antok::plotUtils::GlobalPlotOptions::GlobalPlotOptions(const YAML::Node& optionN
 					statisticsHistInName = "";
 					statisticsHistOutName = "";
 				}
+				if(hasNodeKey(statsHistOpt, "Weight")) {
+					statisticsHistWeightName = antok::YAMLUtils::getString(statsHistOpt["Weight"]);
+					if(statisticsHistWeightName == "") {
+						std::cerr<<"Warning: Could not convert \"Weight\" of \"StatisticsHistogram\" to std::string, filling it unweighted."<<std::endl;
+					}
+				}
 			}
 		}
 	}
@@ -2,11 +2,15 @@
 #define ANTOK_PLOTTER_H
 
 #include<map>
+#include<set>
 #include<string>
 #include<vector>
 
 #include<TH1.h>
 
+class TDirectory;
+class TRandom3;
+
 namespace YAML {
 	class Node;
 }
@@ -14,6 +18,7 @@ namespace YAML {
 namespace antok {
 
 	class Plot;
+	class SummaryPlot;
 
 	namespace plotUtils {
 
@@ -25,6 +30,13 @@ namespace antok {
 			bool plotsWithSingleCutsOff;
 			std::string statisticsHistInName;
 			std::string statisticsHistOutName;
+			std::string statisticsHistWeightName;
+			std::vector<std::string> eventWeightNames;
+			unsigned int poissonReplicas;
+			unsigned int poissonSeed;
+			bool writeEmptyHistograms;
+			unsigned int sparseHistogramThreshold;
+			unsigned int finishThreads;
 			std::map<std::string, std::vector<long> > cutMasks;
 
 		  private:
@@ -33,13 +45,55 @@ namespace antok {
 
 		};
 
+		// name and title of a plot's histogram for one cutmask of a cut train
+		void getHistogramNameAndTitle(const std::string& plotName,
+		                              const std::string& plotTitle,
+		                              const std::string& cutTrainName,
+		                              long cutmask,
+		                              std::string& histName,
+		                              std::string& histTitle);
+
+		// Weights all plots with "Weights: On" are filled with in addition to
+		// the unweighted histogram: the given double variables followed by
+		// Poisson(1) replicas for a bootstrap. update() is called once per
+		// event so that every plot sees the same replica weights.
+		struct eventWeights {
+
+			eventWeights()
+				: poissonReplicas(0),
+				  poissonSeed(0),
+				  random(0) { };
+			~eventWeights();
+
+			void update();
+
+			unsigned int getNWeights() const { return values.size(); }
+
+			std::vector<std::string> names;
+			std::vector<const double*> variables;
+			unsigned int poissonReplicas;
+			// the replicas start from this seed again for every new output
+			unsigned int poissonSeed;
+			TRandom3* random;
+			std::vector<double> values;
+
+		};
+
+		// Cut flow of one cut train. The events surviving each step are counted
+		// in plain integers (and, if a weight is given, sums of weights) and only
+		// added to the labelled waterfall histogram in flush().
 		struct waterfallHistogramContainer {
 
 			waterfallHistogramContainer(TH1* hist,
-			                            std::vector<std::pair<const char*, const bool*> > cuts_)
+			                            std::vector<std::pair<const char*, const bool*> > cuts_,
+			                            const double* weight_ = 0)
 				: histogram(hist),
-				  cuts(cuts_) {
-						int startBin = 1;
+				  cuts(cuts_),
+				  startBin(1),
+				  counts(cuts_.size(), 0),
+				  weight(weight_),
+				  sumOfWeights(weight_ ? cuts_.size() : 0, 0.),
+				  sumOfSquaredWeights(weight_ ? cuts_.size() : 0, 0.) {
 						for(int i = 1; i < histogram->GetNbinsX(); ++i) {
 							if(std::string(histogram->GetXaxis()->GetBinLabel(i)) == "") {
 								startBin = i;
@@ -51,8 +105,34 @@ namespace antok {
 						}
 					};
 
+			inline void fill() {
+				const double w = weight ? *weight : 1.;
+				for(unsigned int i = 0; i < cuts.size(); ++i) {
+					if(not *(cuts[i].second)) {
+						break;
+					}
+					++counts[i];
+					if(weight) {
+						sumOfWeights[i] += w;
+						sumOfSquaredWeights[i] += w*w;
+					}
+				}
+			}
+
+			bool add(const waterfallHistogramContainer& rhs);
+			// adds the bins in front of the cuts from the statistics histogram of an input file
+			bool addInputBins(const TH1* inputHistogram);
+			void flush();
+			// scales the bins of the cuts only, called after flush()
+			void scale(double factor);
+
 			TH1* histogram;
 			std::vector<std::pair<const char*, const bool*> > cuts;
+			int startBin;
+			std::vector<Long64_t> counts;
+			const double* weight;
+			std::vector<double> sumOfWeights;
+			std::vector<double> sumOfSquaredWeights;
 
 		};
 
@@ -67,18 +147,72 @@ namespace antok {
 		static Plotter* instance();
 
 		void fill(long cutPattern);
+		void flush();
+		void registerHistograms();
+		bool writeSummaries();
+		// after finish(), makes the plot directories in the new output file
+		bool resetForNextOutput(bool accumulate);
+
+		bool getWriteEmptyHistograms() const { return _writeEmptyHistograms; }
+		unsigned int getSparseHistogramThreshold() const { return _sparseHistogramThreshold; }
+		const antok::plotUtils::eventWeights* getEventWeights() const { return _eventWeights.getNWeights() ? &_eventWeights : 0; }
+
+		unsigned int registerCutmask(long cutmask);
+		// "0101..." with one digit per cut of the train and the cuts' abbreviations, cached
+		const std::pair<std::string, std::string>& getCutmaskLabels(const std::string& cutTrainName, long cutmask);
+		// creates <cutTrain>/<plotName> in the output file unless already done
+		bool makePlotDirectory(const std::string& cutTrainName, const std::string& plotName);
+		bool cutPatternUsed(long cutPattern) const;
+		// the bins of antok's cuts in the cut flows, the bins copied from the input stay unscaled
+		void scaleWaterfallHistograms(double factor);
+		bool isWaterfallHistogram(const TObject* object) const;
+		// a weighted cut flow needs the weight of every entry
+		bool hasWeightedWaterfall() const;
 
 		static bool handleAdditionalCuts(const YAML::Node& cuts, std::map<std::string, std::vector<long> >& map);
 
 	  private:
 
-		Plotter() { };
+		Plotter()
+			: _writeEmptyHistograms(false),
+			  _sparseHistogramThreshold(1 << 20),
+			  _finishThreads(1) { };
+
+		struct flushThreadArguments {
+			Plotter* plotter;
+			unsigned int threadIndex;
+			unsigned int nThreads;
+		};
+
+		static void* __flushThread(void* arg);
 
 		static Plotter* _plotter;
 
 		std::vector<antok::Plot*> _plots;
+		// also in _plots, kept separately for writeSummaries()
+		std::vector<antok::SummaryPlot*> _summaries;
+		std::string _summaryJsonFileName;
+
+		bool _writeEmptyHistograms;
+		// number of bins above which plots keep their counts in sparse pages
+		unsigned int _sparseHistogramThreshold;
+		// number of threads converting the plots' buffers to histograms in flush()
+		unsigned int _finishThreads;
+
+		// distinct cutmasks of all plots, matched once per event in fill()
+		std::vector<long> _cutmasks;
+		std::map<long, unsigned int> _cutmaskIndices;
+		std::vector<unsigned int> _matchedCutmasks;
+
+		std::map<std::pair<std::string, long>, std::pair<std::string, std::string> > _cutmaskLabels;
+		std::map<std::string, TDirectory*> _cutTrainDirectories;
+		std::set<std::pair<std::string, std::string> > _plotDirectories;
 
 		std::vector<antok::plotUtils::waterfallHistogramContainer> _waterfallHistograms;
+		// in the input file, read again for every input by switchFiles()
+		std::string _statisticsHistInName;
+
+		antok::plotUtils::eventWeights _eventWeights;
 
 	};
 
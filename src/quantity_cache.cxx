@@ -0,0 +1,185 @@
+#include<quantity_cache.h>
+
+#include<iostream>
+#include<sstream>
+
+#include<TDirectory.h>
+#include<TFile.h>
+#include<TTree.h>
+
+#include<data.h>
+
+const char* antok::QuantityCache::__treeName = "antokQuantityCache";
+
+namespace {
+
+	std::string __hashString(ULong64_t hash) {
+		std::stringstream strStr;
+		strStr<<std::hex<<hash;
+		return strStr.str();
+	}
+
+}
+
+antok::QuantityCache::QuantityCache(const std::string& fileName, ULong64_t configHash, const std::vector<std::string>& quantityNames)
+	: _fileName(fileName),
+	  _configHash(configHash),
+	  _quantityNames(quantityNames),
+	  _reading(false),
+	  _writing(false),
+	  _file(0),
+	  _tree(0),
+	  _doubleVectorPointers(quantityNames.size(), 0),
+	  _lorentzVectorPointers(quantityNames.size(), 0),
+	  _vectorPointers(quantityNames.size(), 0) { }
+
+antok::QuantityCache::~QuantityCache() {
+
+	if(_file) {
+		_file->Close();
+		delete _file;
+	}
+
+}
+
+bool antok::QuantityCache::bindBranches(TTree* tree, antok::Data& data, bool create) {
+
+	for(unsigned int i = 0; i < _quantityNames.size(); ++i) {
+		const std::string& name = _quantityNames[i];
+		const std::string type = data.getType(name);
+		if(not create and tree->GetBranch(name.c_str()) == 0) {
+			std::cerr<<"Warning: quantity cache \""<<_fileName<<"\" has no branch \""<<name<<"\", ignoring it."<<std::endl;
+			return false;
+		}
+		if(type == "double") {
+			if(create) {
+				tree->Branch(name.c_str(), data.getAddr<double>(name), (name + "/D").c_str());
+			} else {
+				tree->SetBranchAddress(name.c_str(), data.getAddr<double>(name));
+			}
+		} else if(type == "int") {
+			if(create) {
+				tree->Branch(name.c_str(), data.getAddr<int>(name), (name + "/I").c_str());
+			} else {
+				tree->SetBranchAddress(name.c_str(), data.getAddr<int>(name));
+			}
+		} else if(type == "Long64_t") {
+			if(create) {
+				tree->Branch(name.c_str(), data.getAddr<Long64_t>(name), (name + "/L").c_str());
+			} else {
+				tree->SetBranchAddress(name.c_str(), data.getAddr<Long64_t>(name));
+			}
+		} else if(type == "std::vector<double>") {
+			_doubleVectorPointers[i] = data.getAddr<std::vector<double> >(name);
+			if(create) {
+				tree->Branch(name.c_str(), &_doubleVectorPointers[i]);
+			} else {
+				tree->SetBranchAddress(name.c_str(), &_doubleVectorPointers[i]);
+			}
+		} else if(type == "TLorentzVector") {
+			_lorentzVectorPointers[i] = data.getAddr<TLorentzVector>(name);
+			if(create) {
+				tree->Branch(name.c_str(), &_lorentzVectorPointers[i]);
+			} else {
+				tree->SetBranchAddress(name.c_str(), &_lorentzVectorPointers[i]);
+			}
+		} else if(type == "TVector3") {
+			_vectorPointers[i] = data.getAddr<TVector3>(name);
+			if(create) {
+				tree->Branch(name.c_str(), &_vectorPointers[i]);
+			} else {
+				tree->SetBranchAddress(name.c_str(), &_vectorPointers[i]);
+			}
+		} else if(type == "") {
+			std::cerr<<"Quantity \""<<name<<"\" of the \"QuantityCache\" is not a calculated quantity."<<std::endl;
+			return false;
+		} else {
+			std::cerr<<"Type \""<<type<<"\" of quantity \""<<name<<"\" cannot be stored in the \"QuantityCache\"."<<std::endl;
+			return false;
+		}
+	}
+	return true;
+
+}
+
+bool antok::QuantityCache::load(TTree* inTree, antok::Data& data) {
+
+	TDirectory* previousDirectory = gDirectory;
+	_file = TFile::Open(_fileName.c_str(), "READ");
+	previousDirectory->cd();
+	if(_file == 0 or _file->IsZombie()) {
+		delete _file;
+		_file = 0;
+		return false;
+	}
+	_tree = dynamic_cast<TTree*>(_file->Get(__treeName));
+	if(_tree == 0 or std::string(_tree->GetTitle()) != __hashString(_configHash) or _tree->GetEntries() != inTree->GetEntries()) {
+		std::cout<<"Quantity cache \""<<_fileName<<"\" was made with a different configuration or input, ignoring it."<<std::endl;
+		_tree = 0;
+		_file->Close();
+		delete _file;
+		_file = 0;
+		return false;
+	}
+	if(not bindBranches(_tree, data, false)) {
+		_tree = 0;
+		_file->Close();
+		delete _file;
+		_file = 0;
+		return false;
+	}
+	// reading an entry of the input tree now also reads the cached quantities
+	inTree->AddFriend(_tree);
+	_reading = true;
+	return true;
+
+}
+
+bool antok::QuantityCache::startWriting(antok::Data& data) {
+
+	TDirectory* previousDirectory = gDirectory;
+	_file = TFile::Open(_fileName.c_str(), "RECREATE");
+	if(_file == 0 or _file->IsZombie()) {
+		previousDirectory->cd();
+		std::cerr<<"Could not open quantity cache \""<<_fileName<<"\" for writing."<<std::endl;
+		delete _file;
+		_file = 0;
+		return false;
+	}
+	_tree = new TTree(__treeName, __hashString(_configHash).c_str());
+	previousDirectory->cd();
+	if(not bindBranches(_tree, data, true)) {
+		return false;
+	}
+	_writing = true;
+	return true;
+
+}
+
+bool antok::QuantityCache::fill() {
+
+	if(not _writing) {
+		return true;
+	}
+	return (_tree->Fill() > 0);
+
+}
+
+bool antok::QuantityCache::finish() {
+
+	if(not _writing) {
+		return true;
+	}
+	_writing = false;
+	TDirectory* previousDirectory = gDirectory;
+	_file->cd();
+	_tree->Write();
+	std::cout<<"Wrote "<<_tree->GetEntries()<<" entries of "<<_quantityNames.size()<<" quantities to the quantity cache \""<<_fileName<<"\"."<<std::endl;
+	_file->Close();
+	delete _file;
+	_file = 0;
+	_tree = 0;
+	previousDirectory->cd();
+	return true;
+
+}
@@ -0,0 +1,67 @@
+#ifndef ANTOK_QUANTITY_CACHE_H
+#define ANTOK_QUANTITY_CACHE_H
+
+#include<string>
+#include<vector>
+
+#include<Rtypes.h>
+#include<TLorentzVector.h>
+#include<TVector3.h>
+
+class TFile;
+class TTree;
+
+namespace antok {
+
+	class Data;
+
+	// Friend tree holding chosen calculated quantities for every entry of the
+	// input tree, together with a hash of the configuration which produced
+	// them. If a later run finds a file with a matching hash and number of
+	// entries, the tree is added as a friend of the input tree and the
+	// quantities are read like input branches instead of being calculated.
+	// Otherwise the quantities are written to the file during the run.
+	class QuantityCache {
+
+	  public:
+
+		QuantityCache(const std::string& fileName, ULong64_t configHash, const std::vector<std::string>& quantityNames);
+		~QuantityCache();
+
+		bool load(TTree* inTree, antok::Data& data);
+		bool startWriting(antok::Data& data);
+
+		bool isReading() const { return _reading; }
+		bool isWriting() const { return _writing; }
+
+		const std::vector<std::string>& getQuantityNames() const { return _quantityNames; }
+		TTree* getTree() { return _tree; }
+
+		bool fill();
+		bool finish();
+
+	  private:
+
+		static const char* __treeName;
+
+		bool bindBranches(TTree* tree, antok::Data& data, bool create);
+
+		std::string _fileName;
+		ULong64_t _configHash;
+		std::vector<std::string> _quantityNames;
+		bool _reading;
+		bool _writing;
+
+		TFile* _file;
+		TTree* _tree;
+
+		// object branches need the address of a pointer which stays valid
+		std::vector<std::vector<double>*> _doubleVectorPointers;
+		std::vector<TLorentzVector*> _lorentzVectorPointers;
+		std::vector<TVector3*> _vectorPointers;
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include<sparse_plot.h>
+
+#include<assert.h>
+
+#include<THnSparse.h>
+
+#include<object_manager.h>
+#include<plotter.h>
+
+antok::SparsePlot::SparsePlot(std::map<std::string, std::vector<long> >& cutmasks,
+                              THnSparse* histTemplate,
+                              const std::vector<const double*>& doubleVariables,
+                              const std::vector<const int*>& intVariables)
+	: Plot(),
+	  _histTemplate(histTemplate),
+	  _writeEmptyHistograms(false),
+	  _doubleVariables(doubleVariables),
+	  _intVariables(intVariables),
+	  _coordinates(doubleVariables.size(), 0.)
+{
+
+	assert(_histTemplate != 0);
+	assert(_doubleVariables.size() == _intVariables.size());
+	assert((int)_doubleVariables.size() == _histTemplate->GetNdimensions());
+
+	antok::Plotter& plotter = antok::ObjectManager::instance()->getPlotter();
+	_writeEmptyHistograms = plotter.getWriteEmptyHistograms();
+	const std::string plotName = _histTemplate->GetName();
+
+	for(std::map<std::string, std::vector<long> >::const_iterator cutmasks_it = cutmasks.begin(); cutmasks_it != cutmasks.end(); ++cutmasks_it) {
+		const std::string& cutTrainName = cutmasks_it->first;
+		const std::vector<long>& masks = cutmasks_it->second;
+
+		if(not plotter.makePlotDirectory(cutTrainName, plotName)) {
+			assert(false);
+		}
+		const std::string path = cutTrainName + "/" + plotName;
+
+		for(unsigned int cutmask_i = 0; cutmask_i < masks.size(); ++cutmask_i) {
+			long mask = masks[cutmask_i];
+			std::string histName;
+			std::string histTitle;
+			antok::plotUtils::getHistogramNameAndTitle(plotName, _histTemplate->GetTitle(), cutTrainName, mask, histName, histTitle);
+
+			unsigned int index = plotter.registerCutmask(mask);
+			if(index >= _histograms.size()) {
+				_histograms.resize(index + 1, 0);
+			}
+			if(_histograms[index] == 0) {
+				_histograms[index] = new histogramEntry();
+			}
+			_histograms[index]->registrations.push_back(histogramRegistration(path, histName, histTitle));
+		}
+	}
+
+}
+
+antok::SparsePlot::~SparsePlot() {
+
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		delete _histograms[i];
+	}
+
+}
+
+void antok::SparsePlot::fill(const std::vector<unsigned int>& matchedCutmasks) {
+
+	bool coordinatesSet = false;
+	for(unsigned int i = 0; i < matchedCutmasks.size(); ++i) {
+		unsigned int index = matchedCutmasks[i];
+		if(index >= _histograms.size() or _histograms[index] == 0) {
+			continue;
+		}
+		if(not coordinatesSet) {
+			for(unsigned int j = 0; j < _coordinates.size(); ++j) {
+				_coordinates[j] = _doubleVariables[j] ? (*_doubleVariables[j]) : (*_intVariables[j]);
+			}
+			coordinatesSet = true;
+		}
+		getHistogram(index)->Fill(&_coordinates[0]);
+	}
+
+}
+
+void antok::SparsePlot::registerHistograms() {
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		histogramEntry* entry = _histograms[i];
+		if(entry == 0 or entry->registered or (entry->histogram == 0 and not _writeEmptyHistograms)) {
+			continue;
+		}
+		THnSparse* hist = getHistogram(i);
+		for(unsigned int j = 0; j < entry->registrations.size(); ++j) {
+			const histogramRegistration& registration = entry->registrations[j];
+			assert(objectManager->registerHistogramToCopy(hist,
+			                                              registration.path,
+			                                              registration.name,
+			                                              registration.title));
+		}
+		entry->registered = true;
+	}
+
+}
+
+void antok::SparsePlot::resetForNextOutput(bool accumulate) {
+
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		histogramEntry* entry = _histograms[i];
+		if(entry == 0) {
+			continue;
+		}
+		entry->registered = false;
+		if(not accumulate) {
+			delete entry->histogram;
+			entry->histogram = 0;
+		}
+	}
+
+}
+
+THnSparse* antok::SparsePlot::getHistogram(unsigned int index) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(entry.histogram == 0) {
+		const histogramRegistration& registration = entry.registrations[0];
+		entry.histogram = dynamic_cast<THnSparse*>(_histTemplate->Clone(registration.name.c_str()));
+		assert(entry.histogram != 0);
+		entry.histogram->SetTitle(registration.title.c_str());
+	}
+	return entry.histogram;
+
+}
@@ -0,0 +1,70 @@
+#ifndef ANTOK_SPARSE_PLOT_H
+#define ANTOK_SPARSE_PLOT_H
+
+#include<map>
+#include<string>
+#include<vector>
+
+#include<plot.hpp>
+
+class THnSparse;
+
+namespace antok {
+
+	// N-dimensional plot backed by a THnSparse, filled with any number of
+	// double or int variables in one go. As for the TemplatePlot, there is
+	// one histogram per cutmask, which is only created on the first fill.
+	class SparsePlot : public Plot {
+
+	  public:
+
+		SparsePlot(std::map<std::string, std::vector<long> >& cutmasks,
+		           THnSparse* histTemplate,
+		           const std::vector<const double*>& doubleVariables,
+		           const std::vector<const int*>& intVariables);
+
+		~SparsePlot();
+
+		void fill(const std::vector<unsigned int>& matchedCutmasks);
+		void registerHistograms();
+		void resetForNextOutput(bool accumulate);
+
+	  private:
+
+		struct histogramRegistration {
+			std::string path;
+			std::string name;
+			std::string title;
+			histogramRegistration(const std::string& path_, const std::string& name_, const std::string& title_)
+				: path(path_),
+				  name(name_),
+				  title(title_) { };
+		};
+
+		struct histogramEntry {
+			THnSparse* histogram;
+			std::vector<histogramRegistration> registrations;
+			bool registered;
+			histogramEntry()
+				: histogram(0),
+				  registered(false) { };
+		};
+
+		THnSparse* getHistogram(unsigned int index);
+
+		THnSparse* _histTemplate;
+		bool _writeEmptyHistograms;
+
+		// indexed by the Plotter's cutmask index, 0 where this plot does not have the cutmask
+		std::vector<histogramEntry*> _histograms;
+
+		// for every dimension, either the double or the int address is set
+		std::vector<const double*> _doubleVariables;
+		std::vector<const int*> _intVariables;
+		std::vector<double> _coordinates;
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+#include<summary_plot.h>
+
+#include<assert.h>
+#include<iostream>
+#include<utility>
+
+#include<TFile.h>
+#include<TTree.h>
+
+#include<object_manager.h>
+#include<plotter.h>
+
+antok::SummaryPlot::SummaryPlot(std::map<std::string, std::vector<long> >& cutmasks,
+                                const std::string& variableName,
+                                const double* doubleVariable,
+                                const int* intVariable,
+                                const std::vector<double>* vectorVariable,
+                                unsigned int sketchSize,
+                                const std::vector<double>& quantileLevels)
+	: Plot(),
+	  _variableName(variableName),
+	  _doubleVariable(doubleVariable),
+	  _intVariable(intVariable),
+	  _vectorVariable(vectorVariable),
+	  _quantileLevels(quantileLevels),
+	  _sketchSize(sketchSize)
+{
+
+	assert((_doubleVariable != 0) + (_intVariable != 0) + (_vectorVariable != 0) == 1);
+
+	antok::Plotter& plotter = antok::ObjectManager::instance()->getPlotter();
+	for(std::map<std::string, std::vector<long> >::const_iterator cutmasks_it = cutmasks.begin(); cutmasks_it != cutmasks.end(); ++cutmasks_it) {
+		const std::string& cutTrainName = cutmasks_it->first;
+		const std::vector<long>& masks = cutmasks_it->second;
+		for(unsigned int cutmask_i = 0; cutmask_i < masks.size(); ++cutmask_i) {
+			long mask = masks[cutmask_i];
+			std::string name;
+			std::string title;
+			antok::plotUtils::getHistogramNameAndTitle(_variableName, _variableName, cutTrainName, mask, name, title);
+
+			unsigned int index = plotter.registerCutmask(mask);
+			if(index >= _entries.size()) {
+				_entries.resize(index + 1, 0);
+			}
+			if(_entries[index] == 0) {
+				_entries[index] = new summaryEntry(sketchSize);
+			}
+			_entries[index]->registrations.push_back(summaryRegistration(cutTrainName, name, title));
+		}
+	}
+
+}
+
+antok::SummaryPlot::~SummaryPlot() {
+
+	for(unsigned int i = 0; i < _entries.size(); ++i) {
+		delete _entries[i];
+	}
+
+}
+
+inline void antok::SummaryPlot::addValue(summaryEntry& entry) {
+
+	if(_doubleVariable) {
+		entry.moments.add(*_doubleVariable);
+		entry.sketch.add(*_doubleVariable);
+	} else if(_intVariable) {
+		entry.moments.add(*_intVariable);
+		entry.sketch.add(*_intVariable);
+	} else {
+		for(unsigned int i = 0; i < _vectorVariable->size(); ++i) {
+			entry.moments.add((*_vectorVariable)[i]);
+			entry.sketch.add((*_vectorVariable)[i]);
+		}
+	}
+
+}
+
+void antok::SummaryPlot::fill(const std::vector<unsigned int>& matchedCutmasks) {
+
+	for(unsigned int i = 0; i < matchedCutmasks.size(); ++i) {
+		unsigned int index = matchedCutmasks[i];
+		if(index < _entries.size() and _entries[index] != 0) {
+			addValue(*_entries[index]);
+		}
+	}
+
+}
+
+void antok::SummaryPlot::resetForNextOutput(bool accumulate) {
+
+	if(accumulate) {
+		return;
+	}
+	for(unsigned int i = 0; i < _entries.size(); ++i) {
+		if(_entries[i] != 0) {
+			_entries[i]->moments = antok::RunningMoments();
+			_entries[i]->sketch = antok::QuantileSketch(_sketchSize);
+		}
+	}
+
+}
+
+void antok::SummaryPlot::getResults(std::vector<antok::plotUtils::summaryResult>& results, bool withEmpty) const {
+
+	for(unsigned int i = 0; i < _entries.size(); ++i) {
+		const summaryEntry* entry = _entries[i];
+		if(entry == 0 or (entry->moments.getEntries() == 0 and not withEmpty)) {
+			continue;
+		}
+		antok::plotUtils::summaryResult result;
+		result.variable = _variableName;
+		result.entries = entry->moments.getEntries();
+		result.mean = entry->moments.getMean();
+		result.rms = entry->moments.getRMS();
+		result.min = entry->moments.getMin();
+		result.max = entry->moments.getMax();
+		result.quantileLevels = _quantileLevels;
+		entry->sketch.getQuantiles(_quantileLevels, result.quantiles);
+		result.m2 = entry->moments.getM2();
+		result.sketchSize = entry->sketch.getK();
+		entry->sketch.getState(result.sketchValues, result.sketchLevelSizes);
+		for(unsigned int j = 0; j < entry->registrations.size(); ++j) {
+			result.cutTrain = entry->registrations[j].cutTrain;
+			result.name = entry->registrations[j].name;
+			result.title = entry->registrations[j].title;
+			results.push_back(result);
+		}
+	}
+
+}
+
+void antok::SummaryPlot::writeTree(const std::vector<antok::plotUtils::summaryResult>& results) {
+
+	antok::plotUtils::summaryResult row;
+	std::string* variable = &row.variable;
+	std::string* cutTrain = &row.cutTrain;
+	std::string* name = &row.name;
+	std::string* title = &row.title;
+	std::vector<double>* quantileLevels = &row.quantileLevels;
+	std::vector<double>* quantiles = &row.quantiles;
+	std::vector<double>* sketchValues = &row.sketchValues;
+	std::vector<int>* sketchLevelSizes = &row.sketchLevelSizes;
+	TTree* tree = new TTree("summaries", "summaries");
+	tree->Branch("variable", &variable);
+	tree->Branch("cutTrain", &cutTrain);
+	tree->Branch("name", &name);
+	tree->Branch("title", &title);
+	tree->Branch("entries", &row.entries, "entries/L");
+	tree->Branch("mean", &row.mean, "mean/D");
+	tree->Branch("rms", &row.rms, "rms/D");
+	tree->Branch("min", &row.min, "min/D");
+	tree->Branch("max", &row.max, "max/D");
+	tree->Branch("quantileLevels", &quantileLevels);
+	tree->Branch("quantiles", &quantiles);
+	tree->Branch("m2", &row.m2, "m2/D");
+	tree->Branch("sketchSize", &row.sketchSize, "sketchSize/i");
+	tree->Branch("sketchValues", &sketchValues);
+	tree->Branch("sketchLevelSizes", &sketchLevelSizes);
+	for(unsigned int i = 0; i < results.size(); ++i) {
+		row = results[i];
+		tree->Fill();
+	}
+	tree->Write();
+	delete tree;
+
+}
+
+bool antok::SummaryPlot::mergeTree(TFile* file) {
+
+	TTree* tree = dynamic_cast<TTree*>(file->Get("summaries"));
+	if(tree == 0) {
+		return true;
+	}
+	antok::plotUtils::summaryResult row;
+	std::string* variable = &row.variable;
+	std::string* cutTrain = &row.cutTrain;
+	std::string* name = &row.name;
+	std::string* title = &row.title;
+	std::vector<double>* quantileLevels = &row.quantileLevels;
+	std::vector<double>* sketchValues = &row.sketchValues;
+	std::vector<int>* sketchLevelSizes = &row.sketchLevelSizes;
+	if(tree->SetBranchAddress("variable", &variable) < 0 or
+	   tree->SetBranchAddress("cutTrain", &cutTrain) < 0 or
+	   tree->SetBranchAddress("name", &name) < 0 or
+	   tree->SetBranchAddress("title", &title) < 0 or
+	   tree->SetBranchAddress("entries", &row.entries) < 0 or
+	   tree->SetBranchAddress("mean", &row.mean) < 0 or
+	   tree->SetBranchAddress("min", &row.min) < 0 or
+	   tree->SetBranchAddress("max", &row.max) < 0 or
+	   tree->SetBranchAddress("quantileLevels", &quantileLevels) < 0 or
+	   tree->SetBranchAddress("m2", &row.m2) < 0 or
+	   tree->SetBranchAddress("sketchSize", &row.sketchSize) < 0 or
+	   tree->SetBranchAddress("sketchValues", &sketchValues) < 0 or
+	   tree->SetBranchAddress("sketchLevelSizes", &sketchLevelSizes) < 0)
+	{
+		std::cerr<<"The \"summaries\" tree in \""<<file->GetName()<<"\" has no stored sketches and cannot be merged."<<std::endl;
+		return false;
+	}
+
+	// rows of the same cutTrain and name are merged, in the order they first appear
+	std::vector<antok::plotUtils::summaryResult> results;
+	std::vector<antok::RunningMoments> moments;
+	std::vector<antok::QuantileSketch> sketches;
+	std::map<std::pair<std::string, std::string>, unsigned int> indices;
+	for(Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+		if(tree->GetEntry(entry) <= 0) {
+			std::cerr<<"Could not read entry "<<entry<<" of the \"summaries\" tree in \""<<file->GetName()<<"\"."<<std::endl;
+			return false;
+		}
+		antok::RunningMoments rowMoments(row.entries, row.mean, row.m2, row.min, row.max);
+		antok::QuantileSketch rowSketch(row.sketchSize);
+		if(not rowSketch.setState(row.entries, row.sketchValues, row.sketchLevelSizes)) {
+			std::cerr<<"Could not restore the quantile sketch of \""<<row.name<<"\" in \""<<file->GetName()<<"\"."<<std::endl;
+			return false;
+		}
+		const std::pair<std::string, std::string> key(row.cutTrain, row.name);
+		std::map<std::pair<std::string, std::string>, unsigned int>::const_iterator index_it = indices.find(key);
+		if(index_it == indices.end()) {
+			indices[key] = results.size();
+			results.push_back(row);
+			moments.push_back(rowMoments);
+			sketches.push_back(rowSketch);
+			continue;
+		}
+		if(results[index_it->second].quantileLevels != row.quantileLevels or
+		   not sketches[index_it->second].merge(rowSketch))
+		{
+			std::cerr<<"Cannot merge the summaries \""<<row.name<<"\" with different \"Quantiles\" or \"SketchSize\"."<<std::endl;
+			return false;
+		}
+		moments[index_it->second].merge(rowMoments);
+	}
+	delete tree;
+
+	for(unsigned int i = 0; i < results.size(); ++i) {
+		antok::plotUtils::summaryResult& result = results[i];
+		result.entries = moments[i].getEntries();
+		result.mean = moments[i].getMean();
+		result.rms = moments[i].getRMS();
+		result.min = moments[i].getMin();
+		result.max = moments[i].getMax();
+		result.m2 = moments[i].getM2();
+		sketches[i].getQuantiles(result.quantileLevels, result.quantiles);
+		sketches[i].getState(result.sketchValues, result.sketchLevelSizes);
+	}
+	TDirectory* directory = gDirectory;
+	file->cd();
+	file->Delete("summaries;*");
+	writeTree(results);
+	directory->cd();
+	return true;
+
+}
@@ -0,0 +1,102 @@
+#ifndef ANTOK_SUMMARY_PLOT_H
+#define ANTOK_SUMMARY_PLOT_H
+
+#include<map>
+#include<string>
+#include<vector>
+
+#include<plot.hpp>
+#include<summary_statistics.h>
+
+class TFile;
+
+namespace antok {
+
+	namespace plotUtils {
+
+		struct summaryResult {
+			std::string variable;
+			std::string cutTrain;
+			std::string name;
+			std::string title;
+			Long64_t entries;
+			double mean;
+			double rms;
+			double min;
+			double max;
+			std::vector<double> quantileLevels;
+			std::vector<double> quantiles;
+			// state of the moments and the sketch, to merge the results of several outputs
+			double m2;
+			unsigned int sketchSize;
+			std::vector<double> sketchValues;
+			std::vector<int> sketchLevelSizes;
+		};
+
+	}
+
+	// Streaming moments and a quantile sketch of one variable for each
+	// cutmask, filled like the plots but written as a table of numbers.
+	class SummaryPlot : public Plot {
+
+	  public:
+
+		SummaryPlot(std::map<std::string, std::vector<long> >& cutmasks,
+		            const std::string& variableName,
+		            const double* doubleVariable,
+		            const int* intVariable,
+		            const std::vector<double>* vectorVariable,
+		            unsigned int sketchSize,
+		            const std::vector<double>& quantileLevels);
+
+		~SummaryPlot();
+
+		void fill(const std::vector<unsigned int>& matchedCutmasks);
+		void resetForNextOutput(bool accumulate);
+
+		void getResults(std::vector<antok::plotUtils::summaryResult>& results, bool withEmpty) const;
+
+		// "summaries" tree in the current directory
+		static void writeTree(const std::vector<antok::plotUtils::summaryResult>& results);
+		// merges the rows of the "summaries" tree of a file which belong to the same
+		// cutTrain and name, as after the outputs of several jobs were merged
+		static bool mergeTree(TFile* file);
+
+	  private:
+
+		struct summaryRegistration {
+			std::string cutTrain;
+			std::string name;
+			std::string title;
+			summaryRegistration(const std::string& cutTrain_, const std::string& name_, const std::string& title_)
+				: cutTrain(cutTrain_),
+				  name(name_),
+				  title(title_) { };
+		};
+
+		struct summaryEntry {
+			antok::RunningMoments moments;
+			antok::QuantileSketch sketch;
+			std::vector<summaryRegistration> registrations;
+			summaryEntry(unsigned int sketchSize)
+				: sketch(sketchSize) { };
+		};
+
+		inline void addValue(summaryEntry& entry);
+
+		std::string _variableName;
+		// exactly one of the addresses is set
+		const double* _doubleVariable;
+		const int* _intVariable;
+		const std::vector<double>* _vectorVariable;
+		std::vector<double> _quantileLevels;
+		unsigned int _sketchSize;
+
+		// indexed by the Plotter's cutmask index, 0 where this summary does not have the cutmask
+		std::vector<summaryEntry*> _entries;
+
+	};
+
+}
+
+#endif
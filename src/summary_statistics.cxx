@@ -0,0 +1,195 @@
+#include<summary_statistics.h>
+
+#include<algorithm>
+#include<cmath>
+#include<iostream>
+#include<utility>
+
+void antok::RunningMoments::merge(const RunningMoments& rhs) {
+
+	if(rhs._entries == 0) {
+		return;
+	}
+	if(_entries == 0) {
+		*this = rhs;
+		return;
+	}
+	const double entries = _entries + rhs._entries;
+	const double delta = rhs._mean - _mean;
+	_mean += delta * rhs._entries / entries;
+	_m2 += rhs._m2 + delta * delta * ((double)_entries * rhs._entries / entries);
+	_entries += rhs._entries;
+	_min = std::min(_min, rhs._min);
+	_max = std::max(_max, rhs._max);
+
+}
+
+double antok::RunningMoments::getRMS() const {
+	return std::sqrt(getVariance());
+}
+
+antok::QuantileSketch::QuantileSketch(unsigned int k)
+	: _k(std::max(k, 8U)),
+	  _entries(0),
+	  _size(0),
+	  _maxSize(0),
+	  _randomState(2463534242U)
+{
+	grow();
+}
+
+unsigned int antok::QuantileSketch::getCapacity(unsigned int level) const {
+
+	// the top level holds k entries, each level below 2/3 of the one above
+	const unsigned int depth = _compactors.size() - level - 1;
+	return 2 + (unsigned int)(_k * std::pow(2. / 3., (double)depth));
+
+}
+
+void antok::QuantileSketch::grow() {
+
+	_compactors.push_back(std::vector<double>());
+	_maxSize = 0;
+	for(unsigned int i = 0; i < _compactors.size(); ++i) {
+		_maxSize += getCapacity(i);
+	}
+	_compactors.back().reserve(getCapacity(_compactors.size() - 1) + 1);
+
+}
+
+void antok::QuantileSketch::compress() {
+
+	for(unsigned int level = 0; level < _compactors.size(); ++level) {
+		if(_compactors[level].size() < getCapacity(level)) {
+			continue;
+		}
+		if(level + 1 >= _compactors.size()) {
+			grow();
+		}
+		std::vector<double>& compactor = _compactors[level];
+		std::vector<double>& next = _compactors[level + 1];
+		std::sort(compactor.begin(), compactor.end());
+		// an odd entry out stays on this level
+		const unsigned int start = compactor.size() & 1;
+		_randomState ^= _randomState << 13;
+		_randomState ^= _randomState >> 17;
+		_randomState ^= _randomState << 5;
+		for(unsigned int i = start + (_randomState & 1); i < compactor.size(); i += 2) {
+			next.push_back(compactor[i]);
+		}
+		compactor.resize(start);
+		_size = 0;
+		for(unsigned int i = 0; i < _compactors.size(); ++i) {
+			_size += _compactors[i].size();
+		}
+		if(_size < _maxSize) {
+			break;
+		}
+	}
+
+}
+
+bool antok::QuantileSketch::merge(const QuantileSketch& rhs) {
+
+	if(_k != rhs._k) {
+		std::cerr<<"Cannot merge quantile sketches with different sizes ("<<_k<<" != "<<rhs._k<<")."<<std::endl;
+		return false;
+	}
+	while(_compactors.size() < rhs._compactors.size()) {
+		grow();
+	}
+	for(unsigned int i = 0; i < rhs._compactors.size(); ++i) {
+		_compactors[i].insert(_compactors[i].end(), rhs._compactors[i].begin(), rhs._compactors[i].end());
+		_size += rhs._compactors[i].size();
+	}
+	_entries += rhs._entries;
+	while(_size >= _maxSize) {
+		compress();
+	}
+	return true;
+
+}
+
+void antok::QuantileSketch::getState(std::vector<double>& values, std::vector<int>& levelSizes) const {
+
+	values.clear();
+	values.reserve(_size);
+	levelSizes.resize(_compactors.size());
+	for(unsigned int i = 0; i < _compactors.size(); ++i) {
+		values.insert(values.end(), _compactors[i].begin(), _compactors[i].end());
+		levelSizes[i] = _compactors[i].size();
+	}
+
+}
+
+bool antok::QuantileSketch::setState(Long64_t entries, const std::vector<double>& values, const std::vector<int>& levelSizes) {
+
+	unsigned int nValues = 0;
+	for(unsigned int i = 0; i < levelSizes.size(); ++i) {
+		if(levelSizes[i] < 0) {
+			return false;
+		}
+		nValues += levelSizes[i];
+	}
+	if(nValues != values.size() or entries < 0) {
+		std::cerr<<"Stored quantile sketch is inconsistent ("<<values.size()<<" values for "<<nValues<<" entries of the levels)."<<std::endl;
+		return false;
+	}
+	_compactors.clear();
+	grow();
+	while(_compactors.size() < levelSizes.size()) {
+		grow();
+	}
+	std::vector<double>::const_iterator value_it = values.begin();
+	for(unsigned int i = 0; i < levelSizes.size(); ++i) {
+		_compactors[i].assign(value_it, value_it + levelSizes[i]);
+		value_it += levelSizes[i];
+	}
+	_entries = entries;
+	_size = nValues;
+	while(_size >= _maxSize) {
+		compress();
+	}
+	return true;
+
+}
+
+double antok::QuantileSketch::getQuantile(double q) const {
+
+	std::vector<double> levels(1, q);
+	std::vector<double> quantiles;
+	getQuantiles(levels, quantiles);
+	return quantiles[0];
+
+}
+
+void antok::QuantileSketch::getQuantiles(const std::vector<double>& levels, std::vector<double>& quantiles) const {
+
+	quantiles.assign(levels.size(), 0.);
+	if(_size == 0) {
+		return;
+	}
+	std::vector<std::pair<double, double> > weightedValues;
+	weightedValues.reserve(_size);
+	double totalWeight = 0.;
+	for(unsigned int level = 0; level < _compactors.size(); ++level) {
+		const double weight = std::ldexp(1., level);
+		for(unsigned int i = 0; i < _compactors[level].size(); ++i) {
+			weightedValues.push_back(std::pair<double, double>(_compactors[level][i], weight));
+		}
+		totalWeight += weight * _compactors[level].size();
+	}
+	std::sort(weightedValues.begin(), weightedValues.end());
+	for(unsigned int i = 1; i < weightedValues.size(); ++i) {
+		weightedValues[i].second += weightedValues[i-1].second;
+	}
+	for(unsigned int i = 0; i < levels.size(); ++i) {
+		const double rank = std::min(std::max(levels[i], 0.), 1.) * totalWeight;
+		unsigned int j = 0;
+		while(j + 1 < weightedValues.size() and weightedValues[j].second < rank) {
+			++j;
+		}
+		quantiles[i] = weightedValues[j].first;
+	}
+
+}
@@ -0,0 +1,117 @@
+#ifndef ANTOK_SUMMARY_STATISTICS_H
+#define ANTOK_SUMMARY_STATISTICS_H
+
+#include<vector>
+
+#include<Rtypes.h>
+
+namespace antok {
+
+	// Count, mean, variance, minimum and maximum of a stream of values,
+	// updated with Welford's algorithm and mergeable with Chan's formula.
+	class RunningMoments {
+
+	  public:
+
+		RunningMoments()
+			: _entries(0),
+			  _mean(0.),
+			  _m2(0.),
+			  _min(0.),
+			  _max(0.) { };
+
+		// restores stored moments, m2 is the sum of squared deviations from the mean
+		RunningMoments(Long64_t entries, double mean, double m2, double min, double max)
+			: _entries(entries),
+			  _mean(mean),
+			  _m2(m2),
+			  _min(min),
+			  _max(max) { };
+
+		inline void add(double x) {
+			if(_entries == 0) {
+				_min = x;
+				_max = x;
+			} else {
+				_min = (x < _min) ? x : _min;
+				_max = (x > _max) ? x : _max;
+			}
+			++_entries;
+			const double delta = x - _mean;
+			_mean += delta / _entries;
+			_m2 += delta * (x - _mean);
+		}
+
+		void merge(const RunningMoments& rhs);
+
+		Long64_t getEntries() const { return _entries; }
+		double getMean() const { return _mean; }
+		double getM2() const { return _m2; }
+		double getVariance() const { return (_entries > 0) ? _m2 / _entries : 0.; }
+		double getRMS() const;
+		double getMin() const { return _min; }
+		double getMax() const { return _max; }
+
+	  private:
+
+		Long64_t _entries;
+		double _mean;
+		double _m2;
+		double _min;
+		double _max;
+
+	};
+
+	// KLL quantile sketch (Karnin, Lang, Liberty 2016). Values are kept in a
+	// hierarchy of compactors, an entry on level h standing for 2^h values.
+	// A full level is sorted and every other entry is promoted to the next
+	// level, so the memory stays at O(k) entries for any number of values
+	// and the rank error at about 1/k. Sketches can be merged.
+	class QuantileSketch {
+
+	  public:
+
+		QuantileSketch(unsigned int k = 200);
+
+		inline void add(double x) {
+			_compactors[0].push_back(x);
+			++_entries;
+			if(++_size >= _maxSize) {
+				compress();
+			}
+		}
+
+		bool merge(const QuantileSketch& rhs);
+
+		// the entries of all levels one after the other and the number of entries
+		// per level, so that a stored sketch can be restored and merged
+		void getState(std::vector<double>& values, std::vector<int>& levelSizes) const;
+		bool setState(Long64_t entries, const std::vector<double>& values, const std::vector<int>& levelSizes);
+
+		// value below which a fraction q of the values lies, 0 for an empty sketch
+		double getQuantile(double q) const;
+		void getQuantiles(const std::vector<double>& levels, std::vector<double>& quantiles) const;
+
+		Long64_t getEntries() const { return _entries; }
+		unsigned int getSize() const { return _size; }
+		unsigned int getK() const { return _k; }
+
+	  private:
+
+		unsigned int getCapacity(unsigned int level) const;
+		void grow();
+		void compress();
+
+		unsigned int _k;
+		Long64_t _entries;
+		unsigned int _size;
+		unsigned int _maxSize;
+		// state of the xorshift generator choosing which half of a level survives
+		unsigned int _randomState;
+		std::vector<std::vector<double> > _compactors;
+
+	};
+
+}
+
+#endif
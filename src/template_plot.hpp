@@ -7,11 +7,15 @@
 #include<vector>
 
 #include<TH1.h>
-#include<TFile.h>
+#include<TROOT.h>
+#include<TVirtualMutex.h>
 
 #include<cut.hpp>
 #include<cutter.h>
+#include<multi_weight_histogram.h>
+#include<native_histogram.h>
 #include<plot.hpp>
+#include<plotter.h>
 
 namespace antok {
 
@@ -40,17 +44,77 @@ namespace antok {
 		             std::vector<std::vector<T>*>* data1,
 		             std::vector<std::vector<T>*>* data2 = 0);
 
-		void fill(long cutmask);
+		void fill(const std::vector<unsigned int>& matchedCutmasks);
+		void flush();
+		void registerHistograms();
+		TNamed* createDeferredHistogram(unsigned int index, int slot);
+		bool setEventWeights(const antok::plotUtils::eventWeights* weights);
+		void resetForNextOutput(bool accumulate);
 
-		~TemplatePlot() { };
+		~TemplatePlot();
 
 	  private:
 
-		void makePlot(std::map<std::string, std::vector<long> >& cutmasks, TH1* histTemplate);
+		// values waiting to be given to the histogram with one FillN call
+		struct fillBuffer {
+			std::vector<double> x;
+			std::vector<double> y;
+		};
+
+		struct histogramRegistration {
+			std::string path;
+			std::string name;
+			std::string title;
+			histogramRegistration(const std::string& path_, const std::string& name_, const std::string& title_)
+				: path(path_),
+				  name(name_),
+				  title(title_) { };
+		};
+
+		// Everything belonging to one cutmask. Neither the TH1 nor the native
+		// histogram are allocated before the first value arrives.
+		struct histogramEntry {
+			TH1* histogram;
+			antok::NativeHistogram* nativeHistogram;
+			fillBuffer buffer;
+			// one histogram per event weight if the plot has weights
+			antok::MultiWeightHistogram* weightedHistogram;
+			std::vector<TH1*> weightedHistograms;
+			std::vector<histogramRegistration> registrations;
+			bool registered;
+			histogramEntry()
+				: histogram(0),
+				  nativeHistogram(0),
+				  weightedHistogram(0),
+				  registered(false) { };
+		};
+
+		static const unsigned int __fillBufferSize = 512;
 
-		std::vector<std::pair<TH1*, long> > _histograms;
+		void makePlot(std::map<std::string, std::vector<long> >& cutmasks, TH1* histTemplate);
 
-		std::map<long, TH1*> _cutmaskIndex;
+		void fillHistogram(unsigned int index);
+		inline void bufferValue(unsigned int index, double x);
+		inline void bufferValue(unsigned int index, double x, double y);
+		inline antok::MultiWeightHistogram& getMultiWeightHistogram(histogramEntry& entry);
+		void flushBuffer(unsigned int index);
+		TH1* cloneTemplate(unsigned int index, int slot) const;
+		TH1* getHistogram(unsigned int index);
+		TH1* getWeightedHistogram(unsigned int index, unsigned int slot);
+
+		// indexed by the Plotter's cutmask index, 0 where this plot does not have the cutmask
+		std::vector<histogramEntry*> _histograms;
+
+		TH1* _histTemplate;
+		// histograms with uniform binning are counted in a NativeHistogram and only added to the TH1 when flushed
+		bool _useNativeHistograms;
+		unsigned int _sparseHistogramThreshold;
+		// native and weighted histograms above the sparse threshold are only converted to a TH1
+		// one at a time while they are written, the TH1s would need the full memory otherwise
+		bool _deferNativeHistograms;
+		bool _deferWeightedHistograms;
+		bool _writeEmptyHistograms;
+		const antok::plotUtils::eventWeights* _eventWeights;
 
 		unsigned int _mode;
 
@@ -173,72 +237,341 @@ antok::TemplatePlot<T>::TemplatePlot(std::map<std::string, std::vector<long> >&
 };
 
 template<typename T>
-void antok::TemplatePlot<T>::fill(long cutPattern) {
+antok::TemplatePlot<T>::~TemplatePlot() {
+
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		if(_histograms[i]) {
+			delete _histograms[i]->nativeHistogram;
+			delete _histograms[i]->weightedHistogram;
+			delete _histograms[i];
+		}
+	}
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::fill(const std::vector<unsigned int>& matchedCutmasks) {
+
+	for(unsigned int i = 0; i < matchedCutmasks.size(); ++i) {
+		unsigned int index = matchedCutmasks[i];
+		if(index < _histograms.size() and _histograms[index] != 0) {
+			fillHistogram(index);
+		}
+	}
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::flush() {
 
 	for(unsigned int i = 0; i < _histograms.size(); ++i) {
-		TH1* hist = _histograms[i].first;
-		long histMask = _histograms[i].second;
-		if((histMask&cutPattern) == histMask) {
-			switch(_mode) {
-				case 0: // Pointers to single variables
-					if(_data2 == 0) {
-						hist->Fill(*_data1);
-					} else {
-						hist->Fill(*_data1, *_data2);
-					}
-					break;
-				case 1: // Multiple values, 1 variable
-					for(unsigned int j = 0; j < _vecData1->size(); ++j) {
-						hist->Fill(*(*_vecData1)[j]);
-					}
-					break;
-				case 2: // Multiple values, 2 variables
-					for(unsigned int j = 0; j < _vecData1->size(); ++j) {
-						hist->Fill(*(*_vecData1)[j], *(*_vecData2)[j]);
-					}
-					break;
-				case 3: // Multiple values of varying size, 1 variable
-					for(unsigned int j = 0; j < _vecDataVector1->size(); ++j) {
-						hist->Fill((*_vecDataVector1)[j]);
-					}
-					break;
-				case 4: // Multiple values of varying size, 2 variables
-					if(_vecDataVector1->size() != _vecDataVector2->size()) {
-						std::cerr<<"When filling plot with std::vectors as variables: "
-						         <<"vectors have different size ("
-						         <<_vecDataVector1->size()<<"!="<<_vecDataVector2->size()
-						         <<"). Aborting..."<<std::endl;
-						throw;
-					}
-					for(unsigned int j = 0; j < _vecDataVector1->size(); ++j) {
-						hist->Fill((*_vecDataVector1)[j], (*_vecDataVector2)[j]);
-					}
-					break;
-				case 5: // Multiple vectors with multiple values of varying size, 1 variable
-					for(unsigned int j = 0; j < _multipleVecDataVectors1->size(); ++j) {
-						for(unsigned int k = 0; k < (*_multipleVecDataVectors1)[j]->size(); ++k) {
-							hist->Fill((*(*_multipleVecDataVectors1)[j])[k]);
-						}
-					}
-					break;
-				case 6: // Multiple vectors with multiple values of varying size, 2 variables
-					for(unsigned int j = 0; j < _multipleVecDataVectors1->size(); ++j) {
-						if((*_multipleVecDataVectors1)[j]->size() != (*_multipleVecDataVectors2)[j]->size()) {
-							std::cerr<<"When filling plot with std::vectors as variables and "
-							         <<"\"Indices\" used: sub-vectors for index "<<j<<" of different "
-							         <<"size ("<<(*_multipleVecDataVectors1)[j]->size()<<"!="
-							         <<(*_multipleVecDataVectors2)[j]->size()<<"). Aborting..."<<std::endl;
-							throw;
-						}
-						for(unsigned int k = 0; k < (*_multipleVecDataVectors1)[j]->size(); ++k) {
-							hist->Fill((*(*_multipleVecDataVectors1)[j])[k], (*(*_multipleVecDataVectors2)[j])[k]);
-						}
-					}
-					break;
-				default:
-					throw 1;
+		if(_histograms[i] != 0) {
+			flushBuffer(i);
+		}
+	}
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::registerHistograms() {
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		histogramEntry* entry = _histograms[i];
+		if(entry == 0) {
+			continue;
+		}
+		const bool empty = _deferNativeHistograms ? (entry->nativeHistogram == 0 or entry->nativeHistogram->isEmpty())
+		                                          : (entry->histogram == 0);
+		if(entry->registered or (empty and not _writeEmptyHistograms)) {
+			continue;
+		}
+		for(unsigned int j = 0; j < entry->registrations.size(); ++j) {
+			const histogramRegistration& registration = entry->registrations[j];
+			if(_deferNativeHistograms) {
+				assert(objectManager->registerDeferredHistogram(this, i, -1,
+				                                                registration.path,
+				                                                registration.name,
+				                                                registration.title));
+			} else {
+				assert(objectManager->registerHistogramToCopy(getHistogram(i),
+				                                              registration.path,
+				                                              registration.name,
+				                                              registration.title));
+			}
+		}
+		for(unsigned int slot = 0; _eventWeights and slot < _eventWeights->getNWeights(); ++slot) {
+			const std::string& weightName = _eventWeights->names[slot];
+			for(unsigned int j = 0; j < entry->registrations.size(); ++j) {
+				const histogramRegistration& registration = entry->registrations[j];
+				if(_deferWeightedHistograms) {
+					assert(objectManager->registerDeferredHistogram(this, i, slot,
+					                                                registration.path,
+					                                                registration.name + "_" + weightName,
+					                                                registration.title + " [" + weightName + "]"));
+				} else {
+					assert(objectManager->registerHistogramToCopy(getWeightedHistogram(i, slot),
+					                                              registration.path,
+					                                              registration.name + "_" + weightName,
+					                                              registration.title + " [" + weightName + "]"));
+				}
 			}
 		}
+		entry->registered = true;
+	}
+
+}
+
+template<typename T>
+TNamed* antok::TemplatePlot<T>::createDeferredHistogram(unsigned int index, int slot) {
+
+	histogramEntry& entry = *_histograms[index];
+	TH1* hist = cloneTemplate(index, slot);
+	if(slot < 0) {
+		if(entry.nativeHistogram) {
+			entry.nativeHistogram->addTo(hist);
+		}
+	} else if(entry.weightedHistogram) {
+		entry.weightedHistogram->addTo(slot, hist);
+	}
+	return hist;
+
+}
+
+template<typename T>
+bool antok::TemplatePlot<T>::setEventWeights(const antok::plotUtils::eventWeights* weights) {
+
+	_eventWeights = weights;
+	_deferWeightedHistograms = _eventWeights and
+	                           (unsigned int)_histTemplate->GetNcells() * _eventWeights->getNWeights() > _sparseHistogramThreshold;
+	return true;
+
+}
+
+template<typename T>
+inline antok::MultiWeightHistogram& antok::TemplatePlot<T>::getMultiWeightHistogram(histogramEntry& entry) {
+
+	if(not entry.weightedHistogram) {
+		entry.weightedHistogram = new antok::MultiWeightHistogram(_histTemplate, _eventWeights->getNWeights(), _sparseHistogramThreshold);
+	}
+	return *entry.weightedHistogram;
+
+}
+
+template<typename T>
+inline void antok::TemplatePlot<T>::bufferValue(unsigned int index, double x) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(_eventWeights) {
+		getMultiWeightHistogram(entry).fill(x, &_eventWeights->values[0]);
+	}
+	if(_useNativeHistograms) {
+		if(not entry.nativeHistogram) {
+			entry.nativeHistogram = antok::NativeHistogram::fromTemplate(_histTemplate, _sparseHistogramThreshold);
+		}
+		entry.nativeHistogram->fill(x);
+		return;
+	}
+	entry.buffer.x.push_back(x);
+	if(entry.buffer.x.size() >= __fillBufferSize) {
+		flushBuffer(index);
+	}
+
+}
+
+template<typename T>
+inline void antok::TemplatePlot<T>::bufferValue(unsigned int index, double x, double y) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(_eventWeights) {
+		getMultiWeightHistogram(entry).fill(x, y, &_eventWeights->values[0]);
+	}
+	if(_useNativeHistograms) {
+		if(not entry.nativeHistogram) {
+			entry.nativeHistogram = antok::NativeHistogram::fromTemplate(_histTemplate, _sparseHistogramThreshold);
+		}
+		entry.nativeHistogram->fill(x, y);
+		return;
+	}
+	entry.buffer.x.push_back(x);
+	entry.buffer.y.push_back(y);
+	if(entry.buffer.x.size() >= __fillBufferSize) {
+		flushBuffer(index);
+	}
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::flushBuffer(unsigned int index) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(entry.weightedHistogram and not entry.weightedHistogram->isEmpty() and not _deferWeightedHistograms) {
+		for(unsigned int slot = 0; slot < entry.weightedHistogram->getNSlots(); ++slot) {
+			entry.weightedHistogram->addTo(slot, getWeightedHistogram(index, slot));
+		}
+		entry.weightedHistogram->reset();
+	}
+	if(entry.nativeHistogram) {
+		if(not entry.nativeHistogram->isEmpty() and not _deferNativeHistograms) {
+			entry.nativeHistogram->addTo(getHistogram(index));
+			entry.nativeHistogram->reset();
+		}
+		return;
+	}
+	fillBuffer& buffer = entry.buffer;
+	if(buffer.x.empty()) {
+		return;
+	}
+	TH1* hist = getHistogram(index);
+	if(buffer.y.empty()) {
+		hist->FillN(buffer.x.size(), &buffer.x[0], 0);
+	} else {
+		hist->FillN(buffer.x.size(), &buffer.x[0], &buffer.y[0], 0, 1);
+	}
+	buffer.x.clear();
+	buffer.y.clear();
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::resetForNextOutput(bool accumulate) {
+
+	for(unsigned int i = 0; i < _histograms.size(); ++i) {
+		histogramEntry* entry = _histograms[i];
+		if(entry == 0) {
+			continue;
+		}
+		entry->registered = false;
+		if(accumulate) {
+			continue;
+		}
+		delete entry->histogram;
+		entry->histogram = 0;
+		// only deferred histograms still hold counts here
+		if(entry->nativeHistogram) {
+			entry->nativeHistogram->reset();
+		}
+		if(entry->weightedHistogram) {
+			entry->weightedHistogram->reset();
+		}
+		for(unsigned int slot = 0; slot < entry->weightedHistograms.size(); ++slot) {
+			delete entry->weightedHistograms[slot];
+			entry->weightedHistograms[slot] = 0;
+		}
+	}
+
+}
+
+template<typename T>
+TH1* antok::TemplatePlot<T>::cloneTemplate(unsigned int index, int slot) const {
+
+	// plots might be flushed from several threads, and cloning touches ROOT's global state
+	R__LOCKGUARD(gROOTMutex);
+	const histogramRegistration& registration = _histograms[index]->registrations[0];
+	std::string name = registration.name;
+	std::string title = registration.title;
+	if(slot >= 0) {
+		const std::string& weightName = _eventWeights->names[slot];
+		name += "_" + weightName;
+		title += " [" + weightName + "]";
+	}
+	TH1* hist = dynamic_cast<TH1*>(_histTemplate->Clone(name.c_str()));
+	assert(hist != 0);
+	hist->SetDirectory(0);
+	hist->SetTitle(title.c_str());
+	if(slot >= 0 and hist->GetSumw2N() == 0) {
+		hist->Sumw2();
+	}
+	return hist;
+
+}
+
+template<typename T>
+TH1* antok::TemplatePlot<T>::getHistogram(unsigned int index) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(entry.histogram == 0) {
+		entry.histogram = cloneTemplate(index, -1);
+	}
+	return entry.histogram;
+
+}
+
+template<typename T>
+TH1* antok::TemplatePlot<T>::getWeightedHistogram(unsigned int index, unsigned int slot) {
+
+	histogramEntry& entry = *_histograms[index];
+	if(entry.weightedHistograms.empty()) {
+		entry.weightedHistograms.resize(_eventWeights->getNWeights(), 0);
+	}
+	if(entry.weightedHistograms[slot] == 0) {
+		entry.weightedHistograms[slot] = cloneTemplate(index, slot);
+	}
+	return entry.weightedHistograms[slot];
+
+}
+
+template<typename T>
+void antok::TemplatePlot<T>::fillHistogram(unsigned int index) {
+
+	switch(_mode) {
+		case 0: // Pointers to single variables
+			if(_data2 == 0) {
+				bufferValue(index, *_data1);
+			} else {
+				bufferValue(index, *_data1, *_data2);
+			}
+			break;
+		case 1: // Multiple values, 1 variable
+			for(unsigned int j = 0; j < _vecData1->size(); ++j) {
+				bufferValue(index, *(*_vecData1)[j]);
+			}
+			break;
+		case 2: // Multiple values, 2 variables
+			for(unsigned int j = 0; j < _vecData1->size(); ++j) {
+				bufferValue(index, *(*_vecData1)[j], *(*_vecData2)[j]);
+			}
+			break;
+		case 3: // Multiple values of varying size, 1 variable
+			for(unsigned int j = 0; j < _vecDataVector1->size(); ++j) {
+				bufferValue(index, (*_vecDataVector1)[j]);
+			}
+			break;
+		case 4: // Multiple values of varying size, 2 variables
+			if(_vecDataVector1->size() != _vecDataVector2->size()) {
+				std::cerr<<"When filling plot with std::vectors as variables: "
+				         <<"vectors have different size ("
+				         <<_vecDataVector1->size()<<"!="<<_vecDataVector2->size()
+				         <<"). Aborting..."<<std::endl;
+				throw;
+			}
+			for(unsigned int j = 0; j < _vecDataVector1->size(); ++j) {
+				bufferValue(index, (*_vecDataVector1)[j], (*_vecDataVector2)[j]);
+			}
+			break;
+		case 5: // Multiple vectors with multiple values of varying size, 1 variable
+			for(unsigned int j = 0; j < _multipleVecDataVectors1->size(); ++j) {
+				for(unsigned int k = 0; k < (*_multipleVecDataVectors1)[j]->size(); ++k) {
+					bufferValue(index, (*(*_multipleVecDataVectors1)[j])[k]);
+				}
+			}
+			break;
+		case 6: // Multiple vectors with multiple values of varying size, 2 variables
+			for(unsigned int j = 0; j < _multipleVecDataVectors1->size(); ++j) {
+				if((*_multipleVecDataVectors1)[j]->size() != (*_multipleVecDataVectors2)[j]->size()) {
+					std::cerr<<"When filling plot with std::vectors as variables and "
+					         <<"\"Indices\" used: sub-vectors for index "<<j<<" of different "
+					         <<"size ("<<(*_multipleVecDataVectors1)[j]->size()<<"!="
+					         <<(*_multipleVecDataVectors2)[j]->size()<<"). Aborting..."<<std::endl;
+					throw;
+				}
+				for(unsigned int k = 0; k < (*_multipleVecDataVectors1)[j]->size(); ++k) {
+					bufferValue(index, (*(*_multipleVecDataVectors1)[j])[k], (*(*_multipleVecDataVectors2)[j])[k]);
+				}
+			}
+			break;
+		default:
+			throw 1;
 	}
 
 }
@@ -248,67 +581,49 @@ void antok::TemplatePlot<T>::makePlot(std::map<std::string, std::vector<long> >&
 {
 
 	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
-	antok::Cutter& cutter = objectManager->getCutter();
-	TFile* outFile = objectManager->getOutFile();
+	antok::Plotter& plotter = objectManager->getPlotter();
+
+	histTemplate->SetDirectory(0);
+	_histTemplate = histTemplate;
+	_useNativeHistograms = antok::NativeHistogram::canRepresent(histTemplate);
+	_sparseHistogramThreshold = plotter.getSparseHistogramThreshold();
+	_deferNativeHistograms = _useNativeHistograms and (unsigned int)histTemplate->GetNcells() > _sparseHistogramThreshold;
+	_deferWeightedHistograms = false;
+	_writeEmptyHistograms = plotter.getWriteEmptyHistograms();
+	_eventWeights = 0;
+
+	const std::string plotName = histTemplate->GetName();
+	const std::string plotTitle = histTemplate->GetTitle();
 
 	for(std::map<std::string, std::vector<long> >::const_iterator cutmasks_it = cutmasks.begin(); cutmasks_it != cutmasks.end(); ++cutmasks_it) {
 		const std::string& cutTrainName = cutmasks_it->first;
 		const std::vector<long>& masks = cutmasks_it->second;
-		const std::vector<antok::Cut*>& cuts = cutter.getCutsForCutTrain(cutTrainName);
 
-		histTemplate->SetDirectory(0);
-		std::stringstream strStr;
-		strStr<<"tmptmptmp/"<<cutTrainName;
-		outFile->cd(strStr.str().c_str());
-		TDirectory* dir = TDirectory::CurrentDirectory();
-		dir->mkdir(histTemplate->GetName());
-		dir->cd(histTemplate->GetName());
+		// the histograms are written directly into this directory at the end
+		if(not plotter.makePlotDirectory(cutTrainName, plotName)) {
+			assert(false);
+		}
+		const std::string path = cutTrainName + "/" + plotName;
 
 		for(unsigned int cutmask_i = 0; cutmask_i < masks.size(); ++cutmask_i) {
 
 			long mask = masks[cutmask_i];
-			strStr.str("");
-			strStr<<histTemplate->GetName()<<"_";
+			std::string histName;
+			std::string histTitle;
+			antok::plotUtils::getHistogramNameAndTitle(plotName, plotTitle, cutTrainName, mask, histName, histTitle);
 
-			for(unsigned int i = 0; i < cuts.size(); ++i) {
-				if(cutter.cutOnInCutmask(mask, cuts[i])) {
-					strStr<<"1";
-				} else {
-					strStr<<"0";
-				}
+			unsigned int index = plotter.registerCutmask(mask);
+			if(index >= _histograms.size()) {
+				_histograms.resize(index + 1, 0);
 			}
-			std::string histName = strStr.str();
-
-			strStr.str("");
-			strStr<<histTemplate->GetTitle();
-			strStr<<" "<<cutter.getAbbreviations(mask, cutTrainName);
-			std::string histTitle = strStr.str();
-
-			strStr.str("");
-			strStr<<cutTrainName<<"/"<<histTemplate->GetName();
-			std::string path = strStr.str();
-
-			TH1* hist = 0;
-			if(_cutmaskIndex.find(mask) == _cutmaskIndex.end()) {
-				hist = dynamic_cast<TH1*>(histTemplate->Clone(histName.c_str()));
-				assert(hist != 0);
-				hist->SetTitle(histTitle.c_str());
-				_histograms.push_back(std::pair<TH1*, long>(hist, mask));
-				_cutmaskIndex[mask] = hist;
-			} else {
-				hist = _cutmaskIndex.find(mask)->second;
+			if(_histograms[index] == 0) {
+				_histograms[index] = new histogramEntry();
 			}
-			assert(objectManager->registerHistogramToCopy(hist,
-			                                              path,
-			                                              histName,
-			                                              histTitle));
+			_histograms[index]->registrations.push_back(histogramRegistration(path, histName, histTitle));
 		}
 
 	}
 
-	outFile->cd();
-	histTemplate->Delete();
-
 }
 
 #endif
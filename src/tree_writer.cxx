@@ -0,0 +1,605 @@
+#include<tree_writer.h>
+
+#include<algorithm>
+#include<cstring>
+#include<iostream>
+#include<sstream>
+
+#include<RVersion.h>
+#include<TBranch.h>
+#include<TBranchElement.h>
+#include<TCondition.h>
+#include<TLeaf.h>
+#include<TMutex.h>
+#include<TObjArray.h>
+#include<TROOT.h>
+#include<TThread.h>
+#include<TTree.h>
+
+#include<data.h>
+
+namespace {
+
+	// round to nearest with the given number of mantissa bits, so that the low
+	// bits are zero and compress well; inf and nan are left alone
+	double __truncateMantissa(double value, int mantissaBits) {
+		ULong64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const ULong64_t exponentMask = 0x7ff0000000000000ULL;
+		if((bits & exponentMask) == exponentMask or mantissaBits >= 52) {
+			return value;
+		}
+		const int droppedBits = 52 - mantissaBits;
+		bits += (ULong64_t)1 << (droppedBits - 1);
+		bits &= ~(((ULong64_t)1 << droppedBits) - 1);
+		std::memcpy(&value, &bits, sizeof(bits));
+		return value;
+	}
+
+	float __truncateMantissa(float value, int mantissaBits) {
+		UInt_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const UInt_t exponentMask = 0x7f800000U;
+		if((bits & exponentMask) == exponentMask or mantissaBits >= 23) {
+			return value;
+		}
+		const int droppedBits = 23 - mantissaBits;
+		bits += (UInt_t)1 << (droppedBits - 1);
+		bits &= ~(((UInt_t)1 << droppedBits) - 1);
+		std::memcpy(&value, &bits, sizeof(bits));
+		return value;
+	}
+
+}
+
+antok::TreeWriter::TreeWriter(bool asynchronous, unsigned int queueSize, bool parallelCompression)
+	: _asynchronous(asynchronous),
+	  _queueSize(queueSize),
+	  _parallelCompression(parallelCompression),
+	  _started(false),
+	  _commonTreeMask(0),
+	  _leafBytes(0),
+	  _head(0),
+	  _tail(0),
+	  _count(0),
+	  _finished(false),
+	  _fillError(false),
+	  _mutex(0),
+	  _notEmpty(0),
+	  _notFull(0),
+	  _thread(0)
+{
+	if(_queueSize == 0) {
+		_queueSize = 1;
+	}
+}
+
+antok::TreeWriter::~TreeWriter() {
+
+	if(_thread) {
+		finish();
+	}
+	for(unsigned int i = 0; i < _doubleVectorStaging.size(); ++i) {
+		delete _doubleVectorStaging[i];
+	}
+	for(unsigned int i = 0; i < _floatVectorStaging.size(); ++i) {
+		delete _floatVectorStaging[i];
+	}
+	for(unsigned int i = 0; i < _intVectorStaging.size(); ++i) {
+		delete _intVectorStaging[i];
+	}
+	for(unsigned int i = 0; i < _lorentzVectorStaging.size(); ++i) {
+		delete _lorentzVectorStaging[i];
+	}
+	for(unsigned int i = 0; i < _vectorStaging.size(); ++i) {
+		delete _vectorStaging[i];
+	}
+	for(unsigned int i = 0; i < _reducedFloatVectors.size(); ++i) {
+		delete _reducedFloatVectors[i];
+	}
+	for(unsigned int i = 0; i < _reducedDoubleVectors.size(); ++i) {
+		delete _reducedDoubleVectors[i];
+	}
+	delete _notEmpty;
+	delete _notFull;
+	delete _mutex;
+
+}
+
+bool antok::TreeWriter::setBranchPrecisions(const std::vector<antok::OutputOptions::branchPrecision>& precisions, antok::Data& data) {
+
+	if(_started or not _treesToFill.empty()) {
+		std::cerr<<"Branch precisions have to be set before the output TTrees are added to the TreeWriter."<<std::endl;
+		return false;
+	}
+	for(unsigned int i = 0; i < precisions.size(); ++i) {
+		const antok::OutputOptions::branchPrecision& precision = precisions[i];
+		std::string type = data.getType(precision.name);
+		if(type == "double") {
+			_reducedSources.push_back(data.getAddr<double>(precision.name));
+			_reducedVectorSources.push_back(0);
+		} else if(type == "std::vector<double>" and precision.storage != antok::OutputOptions::branchPrecision::FLOAT16) {
+			_reducedSources.push_back(0);
+			_reducedVectorSources.push_back(data.getAddr<std::vector<double> >(precision.name));
+		} else {
+			std::cerr<<"Branch \""<<precision.name<<"\" in \"BranchPrecision\" has to be a double";
+			if(precision.storage != antok::OutputOptions::branchPrecision::FLOAT16) {
+				std::cerr<<" or std::vector<double>";
+			}
+			std::cerr<<" (found \""<<type<<"\")."<<std::endl;
+			return false;
+		}
+		_precisions.push_back(precision);
+	}
+	// the buffers must not be resized after this point, the trees hold their addresses
+	_reducedFloats.resize(_precisions.size());
+	_reducedDoubles.resize(_precisions.size());
+	_reducedFloatVectors.resize(_precisions.size());
+	_reducedDoubleVectors.resize(_precisions.size());
+	for(unsigned int i = 0; i < _precisions.size(); ++i) {
+		_reducedFloatVectors[i] = new std::vector<float>();
+		_reducedDoubleVectors[i] = new std::vector<double>();
+	}
+	return true;
+
+}
+
+bool antok::TreeWriter::addTree(TTree* tree, long cutmask) {
+
+	if(_started) {
+		std::cerr<<"Cannot add output TTree to TreeWriter after it has been started."<<std::endl;
+		return false;
+	}
+	if(tree == 0) {
+		return false;
+	}
+	for(unsigned int i = 0; i < _precisions.size(); ++i) {
+		const antok::OutputOptions::branchPrecision& precision = _precisions[i];
+		const char* name = precision.name.c_str();
+		if(tree->GetBranch(name)) {
+			std::cerr<<"Output TTree already has a branch \""<<precision.name<<"\" with full precision."<<std::endl;
+			return false;
+		}
+		if(_reducedVectorSources[i]) {
+			if(precision.storage == antok::OutputOptions::branchPrecision::DOUBLE) {
+				tree->Branch(name, &_reducedDoubleVectors[i]);
+			} else {
+				tree->Branch(name, &_reducedFloatVectors[i]);
+			}
+			continue;
+		}
+		std::stringstream leafList;
+		leafList<<precision.name;
+		switch(precision.storage) {
+			case antok::OutputOptions::branchPrecision::FLOAT:
+				leafList<<"/F";
+				tree->Branch(name, &_reducedFloats[i], leafList.str().c_str());
+				break;
+			case antok::OutputOptions::branchPrecision::FLOAT16:
+				leafList<<"/f";
+				if(precision.rangeBits > 0) {
+					leafList<<"["<<precision.rangeMin<<","<<precision.rangeMax<<","<<precision.rangeBits<<"]";
+				}
+				tree->Branch(name, &_reducedFloats[i], leafList.str().c_str());
+				break;
+			case antok::OutputOptions::branchPrecision::DOUBLE:
+				leafList<<"/D";
+				tree->Branch(name, &_reducedDoubles[i], leafList.str().c_str());
+				break;
+		}
+	}
+	_treesToFill.push_back(std::pair<TTree*, long>(tree, cutmask));
+	return true;
+
+}
+
+bool antok::TreeWriter::start() {
+
+	if(_started) {
+		std::cerr<<"TreeWriter started twice."<<std::endl;
+		return false;
+	}
+	_started = true;
+	if(_treesToFill.empty()) {
+		_asynchronous = false;
+	}
+	if(not _asynchronous) {
+		return true;
+	}
+	if(not registerBranches()) {
+		std::cerr<<"Warning: the output TTrees have branches which cannot be buffered, "
+		         <<"falling back to synchronous TTree filling."<<std::endl;
+		_asynchronous = false;
+		return true;
+	}
+	// the trees are already changed here, so there is no falling back
+	if(not bindStaging()) {
+		std::cerr<<"Could not bind the output TTrees to the staging area of the TreeWriter."<<std::endl;
+		return false;
+	}
+
+	_commonTreeMask = -1;
+	for(unsigned int i = 0; i < _treesToFill.size(); ++i) {
+		_commonTreeMask &= _treesToFill[i].second;
+	}
+
+	_queue.resize(_queueSize);
+	for(unsigned int i = 0; i < _queue.size(); ++i) {
+		eventRecord& record = _queue[i];
+		record.leafBytes.resize(_leafBytes);
+		record.doubleVectors.resize(_doubleVectorSources.size());
+		record.floatVectors.resize(_floatVectorSources.size());
+		record.intVectors.resize(_intVectorSources.size());
+		record.lorentzVectors.resize(_lorentzVectorSources.size());
+		record.vectors.resize(_vectorSources.size());
+	}
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+	ROOT::EnableThreadSafety();
+#else
+	TThread::Initialize();
+#endif
+#ifdef R__USE_IMT
+	// compress the baskets of the output trees in parallel where ROOT supports it
+	if(_parallelCompression) {
+		ROOT::EnableImplicitMT();
+		for(unsigned int i = 0; i < _treesToFill.size(); ++i) {
+			_treesToFill[i].first->SetImplicitMT(true);
+		}
+	}
+#endif
+
+	_mutex = new TMutex();
+	_notEmpty = new TCondition(_mutex);
+	_notFull = new TCondition(_mutex);
+	_thread = new TThread("antokTreeWriter", (TThread::VoidRtnFunc_t)&antok::TreeWriter::__writerThread, (void*)this);
+	_thread->Run();
+	return true;
+
+}
+
+bool antok::TreeWriter::registerBranches() {
+
+	// The output trees are clones of the input tree, so their leaves and
+	// objects still point to the buffers the input tree is read into (or to
+	// the reduced precision buffers). These are the sources of the records.
+	TObjArray* branches = _treesToFill[0].first->GetListOfBranches();
+	for(int i = 0; i < branches->GetEntriesFast(); ++i) {
+		TBranch* branch = dynamic_cast<TBranch*>(branches->UncheckedAt(i));
+		if(branch == 0) {
+			continue;
+		}
+		if(branch->IsA() != TBranch::Class()) {
+			if(not registerObjectBranch(branch)) {
+				std::cerr<<"Output branch \""<<branch->GetName()<<"\" of class \""<<branch->GetClassName()<<"\" "
+				         <<"cannot be buffered for asynchronous writing."<<std::endl;
+				return false;
+			}
+			continue;
+		}
+		TObjArray* leaves = branch->GetListOfLeaves();
+		for(int j = 0; j < leaves->GetEntriesFast(); ++j) {
+			TLeaf* leaf = dynamic_cast<TLeaf*>(leaves->UncheckedAt(j));
+			if(leaf == 0 or leaf->InheritsFrom("TLeafC") or leaf->TestBit(TLeaf::kIndirectAddress) or leaf->GetValuePointer() == 0) {
+				std::cerr<<"Output leaf \""<<branch->GetName()<<"."<<(leaf ? leaf->GetName() : "")<<"\" "
+				         <<"cannot be buffered for asynchronous writing."<<std::endl;
+				return false;
+			}
+			// variable length arrays are copied up to the largest length in the input tree
+			Int_t length = leaf->GetLenStatic();
+			if(leaf->GetLeafCount()) {
+				length *= std::max(leaf->GetLeafCount()->GetMaximum(), 1);
+			}
+			leafBuffer buffer;
+			buffer.source = (const char*)leaf->GetValuePointer();
+			buffer.offset = _leafBytes;
+			buffer.size = length * leaf->GetLenType();
+			_leafBuffers.push_back(buffer);
+			// every leaf starts aligned to 8 bytes
+			_leafBytes += ((buffer.size + 7) / 8) * 8;
+		}
+	}
+
+	_treeLeaves.resize(_treesToFill.size());
+	TObjArray* firstLeaves = _treesToFill[0].first->GetListOfLeaves();
+	for(unsigned int tree_i = 0; tree_i < _treesToFill.size(); ++tree_i) {
+		TObjArray* leaves = _treesToFill[tree_i].first->GetListOfLeaves();
+		if(leaves->GetEntriesFast() != firstLeaves->GetEntriesFast()) {
+			std::cerr<<"The output TTrees have different branches."<<std::endl;
+			return false;
+		}
+		for(int i = 0; i < leaves->GetEntriesFast(); ++i) {
+			TLeaf* leaf = dynamic_cast<TLeaf*>(leaves->UncheckedAt(i));
+			TLeaf* firstLeaf = dynamic_cast<TLeaf*>(firstLeaves->UncheckedAt(i));
+			if(leaf == 0 or firstLeaf == 0 or std::strcmp(leaf->GetName(), firstLeaf->GetName()) != 0) {
+				std::cerr<<"The output TTrees have different branches."<<std::endl;
+				return false;
+			}
+			if(leaf->GetBranch()->IsA() == TBranch::Class()) {
+				_treeLeaves[tree_i].push_back(leaf);
+			}
+		}
+		if(_treeLeaves[tree_i].size() != _leafBuffers.size()) {
+			std::cerr<<"The output TTrees have different branches."<<std::endl;
+			return false;
+		}
+	}
+	return true;
+
+}
+
+bool antok::TreeWriter::registerObjectBranch(TBranch* branch) {
+
+	TBranchElement* element = dynamic_cast<TBranchElement*>(branch);
+	if(element == 0 or element->GetObject() == 0) {
+		return false;
+	}
+	const std::string className = branch->GetClassName();
+	const char* object = element->GetObject();
+	if(className == "vector<double>") {
+		_doubleVectorSources.push_back((const std::vector<double>*)object);
+		_doubleVectorStaging.push_back(new std::vector<double>());
+	} else if(className == "vector<float>") {
+		_floatVectorSources.push_back((const std::vector<float>*)object);
+		_floatVectorStaging.push_back(new std::vector<float>());
+	} else if(className == "vector<int>") {
+		_intVectorSources.push_back((const std::vector<int>*)object);
+		_intVectorStaging.push_back(new std::vector<int>());
+	} else if(className == "TLorentzVector") {
+		_lorentzVectorSources.push_back((const TLorentzVector*)object);
+		_lorentzVectorStaging.push_back(new TLorentzVector());
+	} else if(className == "TVector3") {
+		_vectorSources.push_back((const TVector3*)object);
+		_vectorStaging.push_back(new TVector3());
+	} else {
+		return false;
+	}
+	_objectBranchNames.push_back(branch->GetName());
+	return true;
+
+}
+
+bool antok::TreeWriter::bindStaging() {
+
+	// the leaves are pointed to the records by the writer thread
+	for(unsigned int tree_i = 0; tree_i < _treesToFill.size(); ++tree_i) {
+		TTree* tree = _treesToFill[tree_i].first;
+		unsigned int doubleVectors_i = 0;
+		unsigned int floatVectors_i = 0;
+		unsigned int intVectors_i = 0;
+		unsigned int lorentzVectors_i = 0;
+		unsigned int vectors_i = 0;
+		for(unsigned int i = 0; i < _objectBranchNames.size(); ++i) {
+			const char* name = _objectBranchNames[i].c_str();
+			const std::string className = tree->GetBranch(name)->GetClassName();
+			Int_t status = -1;
+			if(className == "vector<double>") {
+				status = tree->SetBranchAddress(name, &_doubleVectorStaging[doubleVectors_i++]);
+			} else if(className == "vector<float>") {
+				status = tree->SetBranchAddress(name, &_floatVectorStaging[floatVectors_i++]);
+			} else if(className == "vector<int>") {
+				status = tree->SetBranchAddress(name, &_intVectorStaging[intVectors_i++]);
+			} else if(className == "TLorentzVector") {
+				status = tree->SetBranchAddress(name, &_lorentzVectorStaging[lorentzVectors_i++]);
+			} else if(className == "TVector3") {
+				status = tree->SetBranchAddress(name, &_vectorStaging[vectors_i++]);
+			}
+			if(status < 0) {
+				std::cerr<<"Could not set the address of output branch \""<<_objectBranchNames[i]<<"\" (class \""<<className<<"\")."<<std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+
+}
+
+void antok::TreeWriter::copyToRecord(eventRecord& record) const {
+
+	char* leafBytes = record.leafBytes.empty() ? 0 : &record.leafBytes[0];
+	for(unsigned int i = 0; i < _leafBuffers.size(); ++i) {
+		const leafBuffer& buffer = _leafBuffers[i];
+		std::memcpy(leafBytes + buffer.offset, buffer.source, buffer.size);
+	}
+	// assign() keeps the capacity of the record, so no allocation in the steady state
+	for(unsigned int i = 0; i < _doubleVectorSources.size(); ++i) {
+		record.doubleVectors[i].assign(_doubleVectorSources[i]->begin(), _doubleVectorSources[i]->end());
+	}
+	for(unsigned int i = 0; i < _floatVectorSources.size(); ++i) {
+		record.floatVectors[i].assign(_floatVectorSources[i]->begin(), _floatVectorSources[i]->end());
+	}
+	for(unsigned int i = 0; i < _intVectorSources.size(); ++i) {
+		record.intVectors[i].assign(_intVectorSources[i]->begin(), _intVectorSources[i]->end());
+	}
+	for(unsigned int i = 0; i < _lorentzVectorSources.size(); ++i) {
+		record.lorentzVectors[i] = *_lorentzVectorSources[i];
+	}
+	for(unsigned int i = 0; i < _vectorSources.size(); ++i) {
+		record.vectors[i] = *_vectorSources[i];
+	}
+
+}
+
+bool antok::TreeWriter::fillFromRecord(eventRecord& record) {
+
+	// the vectors are swapped, not copied, the record gets the old buffers back
+	for(unsigned int i = 0; i < _doubleVectorStaging.size(); ++i) {
+		_doubleVectorStaging[i]->swap(record.doubleVectors[i]);
+	}
+	for(unsigned int i = 0; i < _floatVectorStaging.size(); ++i) {
+		_floatVectorStaging[i]->swap(record.floatVectors[i]);
+	}
+	for(unsigned int i = 0; i < _intVectorStaging.size(); ++i) {
+		_intVectorStaging[i]->swap(record.intVectors[i]);
+	}
+	for(unsigned int i = 0; i < _lorentzVectorStaging.size(); ++i) {
+		*_lorentzVectorStaging[i] = record.lorentzVectors[i];
+	}
+	for(unsigned int i = 0; i < _vectorStaging.size(); ++i) {
+		*_vectorStaging[i] = record.vectors[i];
+	}
+	char* leafBytes = record.leafBytes.empty() ? 0 : &record.leafBytes[0];
+	bool success = true;
+	for(unsigned int tree_i = 0; tree_i < _treesToFill.size(); ++tree_i) {
+		TTree* tree = _treesToFill[tree_i].first;
+		long mask = _treesToFill[tree_i].second;
+		if((mask&record.cutPattern) != mask) {
+			continue;
+		}
+		const std::vector<TLeaf*>& leaves = _treeLeaves[tree_i];
+		for(unsigned int i = 0; i < leaves.size(); ++i) {
+			leaves[i]->SetAddress(leafBytes + _leafBuffers[i].offset);
+		}
+		success = success and (tree->Fill() > 0);
+	}
+	return success;
+
+}
+
+void antok::TreeWriter::reducePrecision() {
+
+	for(unsigned int i = 0; i < _precisions.size(); ++i) {
+		const antok::OutputOptions::branchPrecision& precision = _precisions[i];
+		if(_reducedVectorSources[i] and precision.storage == antok::OutputOptions::branchPrecision::DOUBLE) {
+			const std::vector<double>& source = *_reducedVectorSources[i];
+			std::vector<double>& target = *_reducedDoubleVectors[i];
+			target.resize(source.size());
+			for(unsigned int j = 0; j < source.size(); ++j) {
+				target[j] = __truncateMantissa(source[j], precision.mantissaBits);
+			}
+		} else if(_reducedVectorSources[i]) {
+			const std::vector<double>& source = *_reducedVectorSources[i];
+			std::vector<float>& target = *_reducedFloatVectors[i];
+			target.resize(source.size());
+			for(unsigned int j = 0; j < source.size(); ++j) {
+				target[j] = source[j];
+			}
+			if(precision.mantissaBits > 0) {
+				for(unsigned int j = 0; j < target.size(); ++j) {
+					target[j] = __truncateMantissa(target[j], precision.mantissaBits);
+				}
+			}
+		} else if(precision.storage == antok::OutputOptions::branchPrecision::DOUBLE) {
+			_reducedDoubles[i] = __truncateMantissa(*_reducedSources[i], precision.mantissaBits);
+		} else if(precision.mantissaBits > 0) {
+			_reducedFloats[i] = __truncateMantissa((float)*_reducedSources[i], precision.mantissaBits);
+		} else {
+			// Float16_t is truncated by ROOT when the basket is written
+			_reducedFloats[i] = *_reducedSources[i];
+		}
+	}
+
+}
+
+bool antok::TreeWriter::fillTrees(long cutPattern) {
+
+	bool success = true;
+	for(unsigned int i = 0; i < _treesToFill.size(); ++i) {
+		TTree* tree = _treesToFill[i].first;
+		long mask = _treesToFill[i].second;
+		if((mask&cutPattern) == mask) {
+			success = success and (tree->Fill() > 0);
+		}
+	}
+	return success;
+
+}
+
+bool antok::TreeWriter::acceptsCutPattern(long cutPattern) const {
+
+	for(unsigned int i = 0; i < _treesToFill.size(); ++i) {
+		long mask = _treesToFill[i].second;
+		if((mask&cutPattern) == mask) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
+bool antok::TreeWriter::fill(long cutPattern) {
+
+	if(not _asynchronous) {
+		if(not _precisions.empty()) {
+			reducePrecision();
+		}
+		return fillTrees(cutPattern);
+	}
+
+	// no tree wants this event, nothing to copy
+	if((_commonTreeMask&cutPattern) != _commonTreeMask) {
+		return not _fillError;
+	}
+	// the reduced precision buffers are copied into the record like the other leaves
+	if(not _precisions.empty()) {
+		reducePrecision();
+	}
+
+	_mutex->Lock();
+	while(_count == _queueSize) {
+		_notFull->Wait();
+	}
+	_mutex->UnLock();
+
+	// only the event loop touches the slot at _tail until _count is increased
+	eventRecord& record = _queue[_tail];
+	record.cutPattern = cutPattern;
+	copyToRecord(record);
+
+	_mutex->Lock();
+	_tail = (_tail + 1) % _queueSize;
+	++_count;
+	_notEmpty->Signal();
+	bool success = not _fillError;
+	_mutex->UnLock();
+	return success;
+
+}
+
+void* antok::TreeWriter::__writerThread(void* arg) {
+
+	antok::TreeWriter* writer = (antok::TreeWriter*)arg;
+	while(true) {
+		writer->_mutex->Lock();
+		while(writer->_count == 0 and not writer->_finished) {
+			writer->_notEmpty->Wait();
+		}
+		if(writer->_count == 0) {
+			writer->_mutex->UnLock();
+			break;
+		}
+		writer->_mutex->UnLock();
+
+		bool success = writer->fillFromRecord(writer->_queue[writer->_head]);
+
+		writer->_mutex->Lock();
+		if(not success) {
+			writer->_fillError = true;
+		}
+		writer->_head = (writer->_head + 1) % writer->_queueSize;
+		--(writer->_count);
+		writer->_notFull->Signal();
+		writer->_mutex->UnLock();
+	}
+	return 0;
+
+}
+
+bool antok::TreeWriter::finish() {
+
+	if(not _thread) {
+		return true;
+	}
+	_mutex->Lock();
+	_finished = true;
+	_notEmpty->Signal();
+	_mutex->UnLock();
+	_thread->Join();
+	delete _thread;
+	_thread = 0;
+	if(_fillError) {
+		std::cerr<<"Error while filling output TTrees in the background."<<std::endl;
+	}
+	return not _fillError;
+
+}
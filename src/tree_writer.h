@@ -0,0 +1,143 @@
+#ifndef ANTOK_TREE_WRITER_H
+#define ANTOK_TREE_WRITER_H
+
+#include<string>
+#include<utility>
+#include<vector>
+
+#include<Rtypes.h>
+#include<TLorentzVector.h>
+#include<TVector3.h>
+
+#include<output_options.h>
+
+class TBranch;
+class TCondition;
+class TLeaf;
+class TMutex;
+class TThread;
+class TTree;
+
+namespace antok {
+
+	class Data;
+
+	// Fills the pertinent output trees. In asynchronous mode the event loop only
+	// copies the buffers of the output branches into a bounded ring buffer and
+	// a background thread does the TTree::Fill() (i.e. basket compression and
+	// writing). In synchronous mode, the trees are filled directly.
+	// The branches are buffered generically: plain leaves as raw bytes, to
+	// which the writer points the leaves of the trees before every fill, and
+	// std::vector, TLorentzVector and TVector3 objects, which are swapped or
+	// assigned into the objects the trees are bound to. Trees with other
+	// branches are filled synchronously.
+	// Branches with a reduced storage precision are converted right before
+	// the trees are filled or the event is buffered.
+	class TreeWriter {
+
+	  public:
+
+		// parallelCompression starts ROOT's implicit multi-threading for the whole process
+		TreeWriter(bool asynchronous, unsigned int queueSize, bool parallelCompression = false);
+		~TreeWriter();
+
+		// has to be called before the trees are added, which get the branches
+		bool setBranchPrecisions(const std::vector<antok::OutputOptions::branchPrecision>& precisions, antok::Data& data);
+
+		bool addTree(TTree* tree, long cutmask);
+
+		bool start();
+
+		bool fill(long cutPattern);
+
+		bool acceptsCutPattern(long cutPattern) const;
+
+		bool finish();
+
+		bool isAsynchronous() const { return _asynchronous; }
+		unsigned int getQueueSize() const { return _queueSize; }
+		bool usesParallelCompression() const { return _parallelCompression; }
+
+	  private:
+
+		struct eventRecord {
+			long cutPattern;
+			std::vector<char> leafBytes;
+			std::vector<std::vector<double> > doubleVectors;
+			std::vector<std::vector<float> > floatVectors;
+			std::vector<std::vector<int> > intVectors;
+			std::vector<TLorentzVector> lorentzVectors;
+			std::vector<TVector3> vectors;
+		};
+
+		// a leaf of the first tree, the same leaf of the other trees has the same index
+		struct leafBuffer {
+			const char* source;
+			unsigned int offset;
+			unsigned int size;
+		};
+
+		static void* __writerThread(void* arg);
+
+		bool registerBranches();
+		bool registerObjectBranch(TBranch* branch);
+		bool bindStaging();
+		void copyToRecord(eventRecord& record) const;
+		bool fillFromRecord(eventRecord& record);
+		bool fillTrees(long cutPattern);
+		void reducePrecision();
+
+		bool _asynchronous;
+		unsigned int _queueSize;
+		bool _parallelCompression;
+		bool _started;
+
+		std::vector<std::pair<TTree*, long> > _treesToFill;
+		// cuts every tree needs, used to skip events early in asynchronous mode
+		long _commonTreeMask;
+
+		std::vector<leafBuffer> _leafBuffers;
+		unsigned int _leafBytes;
+		// one list per tree, in the order of _leafBuffers
+		std::vector<std::vector<TLeaf*> > _treeLeaves;
+
+		std::vector<std::string> _objectBranchNames;
+		std::vector<const std::vector<double>*> _doubleVectorSources;
+		std::vector<const std::vector<float>*> _floatVectorSources;
+		std::vector<const std::vector<int>*> _intVectorSources;
+		std::vector<const TLorentzVector*> _lorentzVectorSources;
+		std::vector<const TVector3*> _vectorSources;
+
+		// the object branches of the output trees are bound to these in asynchronous mode
+		std::vector<std::vector<double>*> _doubleVectorStaging;
+		std::vector<std::vector<float>*> _floatVectorStaging;
+		std::vector<std::vector<int>*> _intVectorStaging;
+		std::vector<TLorentzVector*> _lorentzVectorStaging;
+		std::vector<TVector3*> _vectorStaging;
+
+		// one entry per reduced precision branch
+		std::vector<antok::OutputOptions::branchPrecision> _precisions;
+		std::vector<const double*> _reducedSources;
+		std::vector<const std::vector<double>*> _reducedVectorSources;
+		std::vector<float> _reducedFloats;
+		std::vector<double> _reducedDoubles;
+		std::vector<std::vector<float>*> _reducedFloatVectors;
+		std::vector<std::vector<double>*> _reducedDoubleVectors;
+
+		std::vector<eventRecord> _queue;
+		unsigned int _head;
+		unsigned int _tail;
+		unsigned int _count;
+		bool _finished;
+		bool _fillError;
+
+		TMutex* _mutex;
+		TCondition* _notEmpty;
+		TCondition* _notFull;
+		TThread* _thread;
+
+	};
+
+}
+
+#endif
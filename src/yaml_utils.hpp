@@ -72,6 +72,36 @@ namespace antok {
 			return retval;
 		}
 
+		template<>
+		inline TVector3* getAddress<TVector3>(const YAML::Node& node) {
+			TVector3* retval = 0;
+			antok::Data& data = antok::ObjectManager::instance()->getData();
+			std::string name = antok::YAMLUtils::getString(node);
+			if(name == "") {
+				std::cerr<<"Entry has to be either a variable name or a convertible type."<<std::endl;
+				return 0;
+			}
+			retval = data.getAddr<TVector3>(name);
+			if(retval == 0) {
+				std::cerr<<"Variable \""<<name<<"\" not found in Data."<<std::endl;
+				return 0;
+			}
+			return retval;
+		}
+
+		// FNV-1a, used to detect whether cached results belong to a configuration
+		inline ULong64_t getHash(const std::string& str, ULong64_t hash = 14695981039346656037ULL) {
+			for(unsigned int i = 0; i < str.size(); ++i) {
+				hash ^= (unsigned char)str[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		inline ULong64_t getHash(const YAML::Node& node, ULong64_t hash = 14695981039346656037ULL) {
+			return getHash(YAML::Dump(node), hash);
+		}
+
 		inline bool hasNodeKey(const YAML::Node& node, std::string key) {
 			try {
 				return node[key];
@@ -0,0 +1,19 @@
+
+#include<iostream>
+#include<string>
+#include<vector>
+
+#include<event_index.h>
+
+int main(int argc, char* argv[]) {
+	if(argc >= 4) {
+		std::vector<std::string> inFileNames(argv + 3, argv + argc);
+		if(not antok::EventIndex::build(argv[1], inFileNames, argv[2])) {
+			return 1;
+		}
+	} else {
+		std::cerr<<"Usage: "<<argv[0]<<" <index file> <tree name> <input files...>"<<std::endl;
+		return 1;
+	}
+	return 0;
+}
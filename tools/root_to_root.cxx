@@ -1,9 +1,16 @@
 
+#include<algorithm>
 #include<cmath>
+#include<cstdio>
+#include<cstring>
+#include<fcntl.h>
+#include<fstream>
 #include<iostream>
 #include<sstream>
+#include<sys/mman.h>
 #include<sys/stat.h>
 #include<sys/types.h>
+#include<unistd.h>
 
 #include<TClonesArray.h>
 #include<TFile.h>
@@ -14,24 +21,176 @@
 
 #include<basic_calcs.h>
 #include<constants.h>
+#include<flat_event_file.hpp>
 #include<initializer.h>
+#include<output_options.h>
+
+namespace {
+
+	// Collects the events of one mass bin record by record in a temporary
+	// file and transposes them into the arrays of the flat event file when
+	// the bin is complete, so the memory use does not grow with the events.
+	class flatEventWriter {
+
+	  public:
+
+		flatEventWriter(const std::string& fileName,
+		                unsigned int nProdParticles,
+		                unsigned int nDecayParticles,
+		                double massLow,
+		                double massHigh)
+			: _fileName(fileName),
+			  _tmpFileName(fileName + ".tmp"),
+			  _nProdParticles(nProdParticles),
+			  _nDecayParticles(nDecayParticles),
+			  _massLow(massLow),
+			  _massHigh(massHigh),
+			  _nEvents(0),
+			  _record((nProdParticles + nDecayParticles) * antok::FlatEventFile::nComponents()) { }
+
+		bool open() {
+			_tmpFile.open(_tmpFileName.c_str(), std::ios::binary | std::ios::trunc);
+			if(not _tmpFile.is_open()) {
+				std::cerr<<"Could not open \""<<_tmpFileName<<"\" for writing."<<std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		void fill(const std::vector<TLorentzVector>& prodParticles, const std::vector<TLorentzVector>& decayParticles) {
+			unsigned int record_i = 0;
+			for(unsigned int i = 0; i < _nProdParticles; ++i) {
+				record_i = fillParticle(prodParticles[i], record_i);
+			}
+			for(unsigned int i = 0; i < _nDecayParticles; ++i) {
+				record_i = fillParticle(decayParticles[i], record_i);
+			}
+			_tmpFile.write((const char*)&_record[0], _record.size() * sizeof(double));
+			++_nEvents;
+		}
+
+		bool finish();
+
+	  private:
+
+		unsigned int fillParticle(const TLorentzVector& particle, unsigned int record_i) {
+			_record[record_i++] = particle.X();
+			_record[record_i++] = particle.Y();
+			_record[record_i++] = particle.Z();
+			_record[record_i++] = particle.E();
+			return record_i;
+		}
+
+		std::string _fileName;
+		std::string _tmpFileName;
+		unsigned int _nProdParticles;
+		unsigned int _nDecayParticles;
+		double _massLow;
+		double _massHigh;
+		uint64_t _nEvents;
+		std::vector<double> _record;
+		std::ofstream _tmpFile;
+
+	};
+
+	bool flatEventWriter::finish() {
+
+		_tmpFile.close();
+		if(_tmpFile.fail()) {
+			std::cerr<<"Could not write \""<<_tmpFileName<<"\"."<<std::endl;
+			return false;
+		}
+		const unsigned int nArrays = _record.size();
+		const size_t tmpSize = _nEvents * nArrays * sizeof(double);
+		const double* records = 0;
+		void* mapping = 0;
+		if(tmpSize > 0) {
+			const int descriptor = ::open(_tmpFileName.c_str(), O_RDONLY);
+			if(descriptor < 0) {
+				std::cerr<<"Could not open \""<<_tmpFileName<<"\"."<<std::endl;
+				return false;
+			}
+			mapping = mmap(0, tmpSize, PROT_READ, MAP_SHARED, descriptor, 0);
+			close(descriptor);
+			if(mapping == MAP_FAILED) {
+				std::cerr<<"Could not map \""<<_tmpFileName<<"\"."<<std::endl;
+				return false;
+			}
+			records = (const double*)mapping;
+		}
+
+		antok::flatEventFileHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, antok::FlatEventFile::magic(), 8);
+		header.version = antok::FlatEventFile::version();
+		header.nProdParticles = _nProdParticles;
+		header.nDecayParticles = _nDecayParticles;
+		header.alignment = antok::FlatEventFile::alignment();
+		header.nEvents = _nEvents;
+		header.massLow = _massLow;
+		header.massHigh = _massHigh;
+		header.dataOffset = sizeof(header);
+		header.arrayStride = antok::FlatEventFile::arrayStride(_nEvents);
+
+		std::ofstream outFile(_fileName.c_str(), std::ios::binary | std::ios::trunc);
+		outFile.write((const char*)&header, sizeof(header));
+		const std::vector<char> padding(header.arrayStride - _nEvents * sizeof(double), 0);
+		std::vector<double> buffer(8192);
+		for(unsigned int array_i = 0; array_i < nArrays; ++array_i) {
+			for(uint64_t first = 0; first < _nEvents; first += buffer.size()) {
+				const uint64_t nValues = std::min((uint64_t)buffer.size(), _nEvents - first);
+				for(uint64_t i = 0; i < nValues; ++i) {
+					buffer[i] = records[(first + i) * nArrays + array_i];
+				}
+				outFile.write((const char*)&buffer[0], nValues * sizeof(double));
+			}
+			if(not padding.empty()) {
+				outFile.write(&padding[0], padding.size());
+			}
+		}
+		outFile.close();
+		if(mapping) {
+			munmap(mapping, tmpSize);
+		}
+		std::remove(_tmpFileName.c_str());
+		if(outFile.fail()) {
+			std::cerr<<"Could not write flat event file \""<<_fileName<<"\"."<<std::endl;
+			return false;
+		}
+		return true;
+
+	}
+
+}
 
 void convert_root_to_txt(char* infile_name,
                          char* outfile_name,
                          std::string configfilename,
-                         std::string inputType)
+                         std::string inputType,
+                         std::string outputFormat)
 {
 
 	if(not (inputType == "data" or inputType == "gen" or inputType == "acc")) {
 		std::cerr<<"Invalid input type '"<<inputType<<"', must be in {'data', 'gen', 'acc'}"<<std::endl;
 		return;
 	}
+	if(not (outputFormat == "root" or outputFormat == "flat" or outputFormat == "both")) {
+		std::cerr<<"Invalid output format '"<<outputFormat<<"', must be in {'root', 'flat', 'both'}"<<std::endl;
+		return;
+	}
+	const bool writeRoot = (outputFormat != "flat");
+	const bool writeFlat = (outputFormat != "root");
 
 	antok::Initializer* initializer = antok::Initializer::instance();
 	if(not initializer->readConfigFile(configfilename)) {
 		std::cerr<<"Could not open config file. Aborting..."<<std::endl;
 		exit(1);
 	}
+	antok::OutputOptions outputOptions;
+	if(not initializer->readOutputOptions(outputOptions)) {
+		std::cerr<<"Could not read the \"OutputOptions\". Aborting..."<<std::endl;
+		exit(1);
+	}
 
 	const double& PION_MASS = antok::Constants::chargedPionMass();
 	const double& PROTON_MASS = antok::Constants::protonMass();
@@ -56,9 +215,11 @@ void convert_root_to_txt(char* infile_name,
 	}
 
 	// Make dirs and open output files.
+	const unsigned int nBins = bounds.size()-1;
+	const unsigned int nProdParticles = (inputType == "data") ? 1 : 2;
 	std::vector<TFile*> tfiles;
-	tfiles.resize(bounds.size()-1, 0);
-	for(unsigned int i = 0; i < tfiles.size(); ++i) {
+	std::vector<flatEventWriter*> flatWriters;
+	for(unsigned int i = 0; i < nBins; ++i) {
 		std::ostringstream strs;
 		strs<<outfile_name<<"/"<<(int)(floor(bounds.at(i)*1000. + 0.5))<<"."<<(int)(floor(bounds.at(i+1)*1000. + 0.5));
 		mkdir(strs.str().c_str(), S_IRWXU | S_IRWXG);
@@ -68,11 +229,19 @@ void convert_root_to_txt(char* infile_name,
 		} else if(inputType == "acc") {
 			strs<<"."<<RECO_FILENAME_POSTFIX;
 		}
-		strs<<".root";
-		tfiles.at(i) = TFile::Open(strs.str().c_str(), "NEW");
-		if(tfiles.at(i) == 0) {
-			std::cout<<"Error opening file for writing."<<std::endl;
-			return;
+		if(writeRoot) {
+			tfiles.push_back(TFile::Open((strs.str() + ".root").c_str(), "NEW"));
+			if(tfiles.back() == 0) {
+				std::cout<<"Error opening file for writing."<<std::endl;
+				return;
+			}
+			outputOptions.applyToFile(tfiles.back());
+		}
+		if(writeFlat) {
+			flatWriters.push_back(new flatEventWriter(strs.str() + ".flat", nProdParticles, 5, bounds.at(i), bounds.at(i+1)));
+			if(not flatWriters.back()->open()) {
+				return;
+			}
 		}
 	}
 
@@ -143,6 +312,8 @@ void convert_root_to_txt(char* infile_name,
 
 	std::vector<TLorentzVector> particles;
 	particles.resize(6);
+	std::vector<TLorentzVector> prodParticles(nProdParticles);
+	std::vector<TLorentzVector> decayParticles(5);
 
 	TClonesArray* prodMomName;
 	if(inputType == "data") {
@@ -169,7 +340,7 @@ void convert_root_to_txt(char* infile_name,
 	trees.resize(tfiles.size(), 0);
 
 	const int splitLevel = 99;
-	const int buffsize = 256000;
+	const int buffsize = (outputOptions.basketSize > 0) ? outputOptions.basketSize : 256000;
 
 	// Create all the trees with their branches.
 	for(unsigned int i = 0; i < tfiles.size(); ++i) {
@@ -177,6 +348,9 @@ void convert_root_to_txt(char* infile_name,
 		trees.at(i) = new TTree("rootPwaEvtTree", "rootPwaEvtTree");
 		trees.at(i)->Branch("prodKinMomenta", "TClonesArray", &prodMom, buffsize, splitLevel);
 		trees.at(i)->Branch("decayKinMomenta", "TClonesArray", &decayMom, buffsize, splitLevel);
+		if(outputOptions.autoFlush != 0) {
+			trees.at(i)->SetAutoFlush(outputOptions.autoFlush);
+		}
 		prodMomName->Write("prodKinParticles", TObject::kSingleKey);
 		decayMomName.Write("decayKinParticles", TObject::kSingleKey);
 	}
@@ -225,21 +399,46 @@ void convert_root_to_txt(char* infile_name,
 			}
 		}
 
+		if(writeFlat) {
+			prodParticles.at(0) = particles.at(0);
+			if(inputType != "data") {
+				prodParticles.at(1).SetXYZM(pxR, pyR, pzR, PROTON_MASS);
+			}
+			for(unsigned int i = 1; i < 6; ++i) {
+				decayParticles.at(i-1) = particles.at(i);
+			}
+			for(unsigned int i = 0; i < flatWriters.size(); ++i) {
+				if((mass > bounds.at(i)) && (mass < bounds.at(i+1))) {
+					flatWriters.at(i)->fill(prodParticles, decayParticles);
+				}
+			}
+		}
+
 	} // End loop over events
 
 	for(unsigned int i = 0; i < tfiles.size(); ++i) {
 		std::cout<<"Mass bin "<<i<<" has "<<trees.at(i)->GetEntries()<<" events."<<std::endl;
 		tfiles.at(i)->cd();
 		trees.at(i)->Write();
+		antok::OutputOptions::reportTreeSize(trees.at(i), tfiles.at(i)->GetName());
 		tfiles.at(i)->Close();
 	}
+	for(unsigned int i = 0; i < flatWriters.size(); ++i) {
+		if(not flatWriters.at(i)->finish()) {
+			std::cerr<<"Could not write the flat event file of mass bin "<<i<<"."<<std::endl;
+		}
+		delete flatWriters.at(i);
+	}
 
 }
 
 int main(int argc, char* argv[]) {
 	if(argc == 5) {
-		convert_root_to_txt(argv[1], argv[2], argv[3], argv[4]);
+		convert_root_to_txt(argv[1], argv[2], argv[3], argv[4], "root");
+	} else if(argc == 6) {
+		convert_root_to_txt(argv[1], argv[2], argv[3], argv[4], argv[5]);
 	} else {
-		std::cerr<<"Wrong number of arguments, is "<<argc<<", should be 4."<<std::endl;
+		std::cerr<<"Wrong number of arguments, is "<<argc<<", should be 4 or 5."<<std::endl;
+		std::cerr<<"Usage: "<<argv[0]<<" <infile> <outdir> <config> <data|gen|acc> [root|flat|both]"<<std::endl;
 	}
 }
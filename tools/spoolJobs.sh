@@ -0,0 +1,69 @@
+#!/bin/bash
+
+# Hands input files to a treereader running with "--spool <spool directory>".
+# Every input file becomes one job writing <output directory>/<input name>,
+# with "-a" the histograms of the jobs are accumulated.
+#
+# usage: spoolJobs.sh [-a] [-w] <spool directory> <output directory> <input files...>
+#        -w waits until all jobs are done and lists the failed ones
+
+
+ACCUMULATE=""
+WAIT=0
+while getopts "aw" OPTION
+do
+	case ${OPTION} in
+		a) ACCUMULATE=" accumulate";;
+		w) WAIT=1;;
+		*) exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [[ $# -lt 3 ]]
+then
+	echo "usage: $(basename $0) [-a] [-w] <spool directory> <output directory> <input files...>"
+	exit 1
+fi
+SPOOL_DIR=$(readlink --canonicalize $1)
+OUTPUT_DIR=$(readlink --canonicalize $2)
+shift 2
+if [[ ! -d ${SPOOL_DIR} || ! -d ${OUTPUT_DIR} ]]
+then
+	echo "!!! error: '${SPOOL_DIR}' or '${OUTPUT_DIR}' does not exist"
+	exit 1
+fi
+
+PREFIX=$(date +%s)_$$
+JOBS=()
+COUNTER=0
+for INPUT_FILE in "$@"
+do
+	JOB=$(printf "%s_%06d" ${PREFIX} ${COUNTER})
+	# written under another name first, the daemon only picks up complete jobs
+	echo "$(readlink --canonicalize ${INPUT_FILE}) ${OUTPUT_DIR}/$(basename ${INPUT_FILE})${ACCUMULATE}" > ${SPOOL_DIR}/${JOB}.tmp
+	mv ${SPOOL_DIR}/${JOB}.tmp ${SPOOL_DIR}/${JOB}.job
+	JOBS+=(${JOB})
+	COUNTER=$((COUNTER + 1))
+done
+echo ">>> spooled ${COUNTER} jobs in '${SPOOL_DIR}'"
+
+if [[ ${WAIT} -eq 0 ]]
+then
+	exit 0
+fi
+FAILED=0
+for JOB in ${JOBS[@]}
+do
+	while [[ -e ${SPOOL_DIR}/${JOB}.job || -e ${SPOOL_DIR}/${JOB}.running ]]
+	do
+		sleep 1
+	done
+	if [[ -e ${SPOOL_DIR}/${JOB}.failed ]]
+	then
+		echo "!!! job ${JOB} ($(cat ${SPOOL_DIR}/${JOB}.failed)) failed"
+		FAILED=$((FAILED + 1))
+	fi
+done
+echo ">>> all jobs finished, ${FAILED} failed"
+[[ ${FAILED} -eq 0 ]]
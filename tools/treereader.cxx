@@ -1,20 +1,33 @@
 
+#include<algorithm>
+#include<cstdio>
+#include<dirent.h>
+#include<fstream>
 #include<iostream>
+#include<map>
 #include<signal.h>
+#include<sstream>
+#include<stdlib.h>
+#include<unistd.h>
+#include<vector>
 
 #include <boost/progress.hpp>
 
 #include<TApplication.h>
 #include<TFile.h>
+#include<TFileMerger.h>
 #include<TTree.h>
 #include<TStyle.h>
 
 #include<constants.h>
 #include<cutter.h>
 #include<event.h>
+#include<event_index.h>
+#include<incremental_manifest.h>
 #include<initializer.h>
 #include<object_manager.h>
 #include<plotter.h>
+#include<summary_plot.h>
 
 #include<assert.h>
 
@@ -24,6 +37,43 @@ void signal_handler(int signum) {
 	ABORT = true;
 }
 
+bool processEntries(antok::ObjectManager* objectManager) {
+
+	// everything, or only some clusters in preview mode
+	const std::vector<std::pair<Long64_t, Long64_t> >& entryRanges = objectManager->getEntryRanges();
+	Long64_t nEntries = 0;
+	for(unsigned int range_i = 0; range_i < entryRanges.size(); ++range_i) {
+		nEntries += entryRanges[range_i].second - entryRanges[range_i].first;
+	}
+
+	boost::progress_display* progressIndicator = new boost::progress_display(nEntries, std::cout, "");
+
+	Long64_t nProcessed = 0;
+	for(unsigned int range_i = 0; range_i < entryRanges.size() and not ABORT; ++range_i) {
+		for(Long64_t i = entryRanges[range_i].first; i < entryRanges[range_i].second; ++i) {
+
+			if(ABORT) {
+				double percent = 100. * ((double)nProcessed / (double)nEntries);
+				std::cout<<"At event "<<i<<" ("<<nProcessed<<" of "<<nEntries<<", "<<percent<<"%)."<<std::endl;
+				std::cout<<"Caught CTRL-C, aborting..."<<std::endl;
+				break;
+			}
+
+			if(not objectManager->processEntry(i)) {
+				std::cerr<<"Could not process event "<<i<<". Aborting..."<<std::endl;
+				return false;
+			}
+
+			++nProcessed;
+			++(*progressIndicator);
+
+		}
+	}
+	delete progressIndicator;
+	return true;
+
+}
+
 void treereader(char* infilename=0, char* outfilename=0, std::string configfilename = "../config/default.yaml") {
 
 	new TApplication("app", 0, 0);
@@ -68,41 +118,424 @@ void treereader(char* infilename=0, char* outfilename=0, std::string configfilen
 		std::cerr<<"Error while initializing. Aborting..."<<std::endl;
 		exit(1);
 	}
-	TTree* inTree = objectManager->getInTree();
 
-	boost::progress_display* progressIndicator = new boost::progress_display(inTree->GetEntries(), std::cout, "");
+	if(not processEntries(objectManager)) {
+		exit(1);
+	}
+
+	if(not objectManager->finish()) {
+		std::cerr<<"Problem when writing TObjects and/or closing output file."<<std::endl;
+	}
+
+}
+
+// A job is a file "<name>.job" in the spool directory holding the input and
+// output file name and optionally "accumulate". It is renamed to
+// "<name>.running" while it is processed and to "<name>.done" or
+// "<name>.failed" afterwards. A file called "stop" ends the daemon once no
+// jobs are left.
+struct spoolJob {
+	std::string inFileName;
+	std::string outFileName;
+	bool accumulate;
+};
+
+std::string nextSpoolJob(const std::string& spoolDirectory) {
+
+	DIR* directory = opendir(spoolDirectory.c_str());
+	if(directory == 0) {
+		return "";
+	}
+	std::vector<std::string> jobs;
+	for(struct dirent* entry = readdir(directory); entry != 0; entry = readdir(directory)) {
+		const std::string name = entry->d_name;
+		if(name.size() > 4 and name.substr(name.size() - 4) == ".job") {
+			jobs.push_back(name);
+		}
+	}
+	closedir(directory);
+	if(jobs.empty()) {
+		return "";
+	}
+	return *std::min_element(jobs.begin(), jobs.end());
+
+}
+
+bool readSpoolJob(const std::string& jobFileName, spoolJob& job) {
+
+	std::ifstream jobFile(jobFileName.c_str());
+	std::string option;
+	if(not (jobFile>>job.inFileName>>job.outFileName)) {
+		std::cerr<<"Could not read input and output file name from job \""<<jobFileName<<"\"."<<std::endl;
+		return false;
+	}
+	job.accumulate = false;
+	if(jobFile>>option) {
+		if(option != "accumulate") {
+			std::cerr<<"Unknown option \""<<option<<"\" in job \""<<jobFileName<<"\"."<<std::endl;
+			return false;
+		}
+		job.accumulate = true;
+	}
+	return true;
+
+}
+
+// Initializes once with the first job and keeps everything for the following
+// ones, which only exchange the files.
+void treereaderDaemon(std::string spoolDirectory, std::string configfilename = "../config/default.yaml") {
+
+	new TApplication("app", 0, 0);
+
+	gStyle->SetPalette(1);
+	gStyle->SetCanvasColor(10);
+	gStyle->SetPadColor(10);
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Initializer* initializer = antok::Initializer::instance();
+	if(not initializer->readConfigFile(configfilename)) {
+		std::cerr<<"Could not open config file. Aborting..."<<std::endl;
+		exit(1);
+	}
+
+	std::cout<<"Waiting for jobs in spool directory \""<<spoolDirectory<<"\"."<<std::endl;
+	bool initialized = false;
+	unsigned int nJobs = 0;
+	while(not ABORT) {
+
+		const std::string jobName = nextSpoolJob(spoolDirectory);
+		if(jobName == "") {
+			if(access((spoolDirectory + "/stop").c_str(), F_OK) == 0) {
+				break;
+			}
+			sleep(1);
+			continue;
+		}
+		const std::string jobBaseName = spoolDirectory + "/" + jobName.substr(0, jobName.size() - 4);
+		if(std::rename((spoolDirectory + "/" + jobName).c_str(), (jobBaseName + ".running").c_str()) != 0) {
+			// taken by somebody else
+			continue;
+		}
+
+		spoolJob job;
+		bool success = readSpoolJob(jobBaseName + ".running", job);
+		TFile* infile = 0;
+		TFile* outfile = 0;
+		if(success) {
+			infile = TFile::Open(job.inFileName.c_str(), "READ");
+			outfile = TFile::Open(job.outFileName.c_str(), "NEW");
+			success = (infile != 0 and outfile != 0);
+			if(not success) {
+				std::cerr<<"Could not open \""<<job.inFileName<<"\" or \""<<job.outFileName<<"\"."<<std::endl;
+			}
+		}
+		if(success) {
+			if(not initialized) {
+				assert(objectManager->setInFile(infile));
+				assert(objectManager->setOutFile(outfile));
+				if(not (initializer->initAll() and initializer->canSwitchFiles())) {
+					std::cerr<<"Error while initializing. Aborting..."<<std::endl;
+					exit(1);
+				}
+				initialized = true;
+			} else if(not initializer->switchFiles(infile, outfile, job.accumulate)) {
+				std::cerr<<"Error while switching to the files of job \""<<jobName<<"\". Aborting..."<<std::endl;
+				exit(1);
+			}
+			success = processEntries(objectManager) and not ABORT;
+			if(not objectManager->finish()) {
+				std::cerr<<"Problem when writing TObjects and/or closing output file."<<std::endl;
+				success = false;
+			}
+		} else {
+			if(infile) {
+				infile->Close();
+			}
+			if(outfile) {
+				outfile->Close();
+			}
+		}
+		delete infile;
+		delete outfile;
+
+		std::rename((jobBaseName + ".running").c_str(), (jobBaseName + (success ? ".done" : ".failed")).c_str());
+		++nJobs;
+		std::cout<<"Job \""<<jobName<<"\" "<<(success ? "done" : "failed")<<", "<<nJobs<<" jobs processed."<<std::endl;
+
+	}
+
+}
 
-	for(unsigned int i = 0; i < inTree->GetEntries(); ++i) {
+// Adds up the histograms and trees of all files, the result replaces outFileName
+// (together with the manifest, if given) only when complete.
+bool mergeOutputs(const std::vector<std::string>& fileNames, const std::string& outFileName, const antok::IncrementalManifest* manifest = 0) {
 
-		if(ABORT) {
-			double percent = 100. * ((double)i / (double)(inTree->GetEntries()));
-			std::cout<<"At event "<<i<<" of "<<inTree->GetEntries()<<" ("<<percent<<"%)."<<std::endl;
-			std::cout<<"Caught CTRL-C, aborting..."<<std::endl;
-			break;
+	TFileMerger merger(false);
+	const std::string mergedFileName = outFileName + ".new";
+	bool success = merger.OutputFile(mergedFileName.c_str(), "RECREATE");
+	for(unsigned int i = 0; i < fileNames.size(); ++i) {
+		success = success and merger.AddFile(fileNames[i].c_str(), false);
+	}
+	success = success and merger.Merge();
+	if(success) {
+		// the summaries of the files are appended by the merger and have to be combined
+		TFile* mergedFile = TFile::Open(mergedFileName.c_str(), "UPDATE");
+		success = (mergedFile != 0) and antok::SummaryPlot::mergeTree(mergedFile) and
+		          (manifest == 0 or manifest->write(mergedFile));
+		if(mergedFile) {
+			mergedFile->Close();
+			delete mergedFile;
 		}
+	}
+	success = success and std::rename(mergedFileName.c_str(), outFileName.c_str()) == 0;
+	if(not success) {
+		std::cerr<<"Could not merge the results into \""<<outFileName<<"\"."<<std::endl;
+	}
+	return success;
+
+}
 
-		inTree->GetEntry(i);
+// Processes only the inputs which are not yet in the manifest of the
+// cumulative output and merges their results into it. Everything is
+// processed again if the config or one of the known inputs changed.
+void treereaderIncremental(std::string outfilename, std::string configfilename, const std::vector<std::string>& infilenames) {
 
-		if(not objectManager->magic()) {
-			std::cerr<<"Could not process event "<<i<<". Aborting..."<<std::endl;
+	new TApplication("app", 0, 0);
+
+	gStyle->SetPalette(1);
+	gStyle->SetCanvasColor(10);
+	gStyle->SetPadColor(10);
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Initializer* initializer = antok::Initializer::instance();
+	if(not initializer->readConfigFile(configfilename)) {
+		std::cerr<<"Could not open config file. Aborting..."<<std::endl;
+		exit(1);
+	}
+
+	antok::IncrementalManifest manifest(initializer->getConfigHash());
+	bool rebuild = not manifest.read(outfilename);
+	std::vector<antok::IncrementalManifest::inputFile> allFiles;
+	std::vector<antok::IncrementalManifest::inputFile> newFiles;
+	for(unsigned int i = 0; i < infilenames.size(); ++i) {
+		char* path = realpath(infilenames[i].c_str(), 0);
+		antok::IncrementalManifest::inputFile file;
+		if(path == 0 or not antok::IncrementalManifest::getInputFile(path, file)) {
+			std::cerr<<"Could not find input file \""<<infilenames[i]<<"\". Aborting..."<<std::endl;
 			exit(1);
 		}
+		free(path);
+		allFiles.push_back(file);
+		const int state = manifest.getState(file);
+		if(state == antok::IncrementalManifest::CHANGEDFILE) {
+			std::cout<<"Input file \""<<file.path<<"\" changed since it was processed."<<std::endl;
+			rebuild = true;
+		} else if(state == antok::IncrementalManifest::NEWFILE) {
+			newFiles.push_back(file);
+		}
+	}
+	if(rebuild) {
+		std::cout<<"Processing all "<<allFiles.size()<<" input files for \""<<outfilename<<"\"."<<std::endl;
+		manifest.clear();
+		newFiles = allFiles;
+	} else if(newFiles.empty()) {
+		std::cout<<"All input files are already in \""<<outfilename<<"\"."<<std::endl;
+		return;
+	} else {
+		std::cout<<"Adding "<<newFiles.size()<<" new input files to \""<<outfilename<<"\"."<<std::endl;
+	}
 
-		++(*progressIndicator);
+	// every new input file gets an output of its own, merged at the end
+	std::vector<std::string> partFileNames;
+	for(unsigned int i = 0; i < newFiles.size() and not ABORT; ++i) {
+		std::stringstream strStr;
+		strStr<<outfilename<<".part"<<i;
+		partFileNames.push_back(strStr.str());
+		TFile* infile = TFile::Open(newFiles[i].path.c_str(), "READ");
+		TFile* outfile = TFile::Open(partFileNames.back().c_str(), "RECREATE");
+		if(infile == 0 or outfile == 0) {
+			std::cerr<<"Could not open \""<<newFiles[i].path<<"\" or \""<<partFileNames.back()<<"\". Aborting..."<<std::endl;
+			exit(1);
+		}
+		if(i == 0) {
+			assert(objectManager->setInFile(infile));
+			assert(objectManager->setOutFile(outfile));
+			if(not (initializer->initAll() and initializer->canSwitchFiles())) {
+				std::cerr<<"Error while initializing. Aborting..."<<std::endl;
+				exit(1);
+			}
+		} else if(not initializer->switchFiles(infile, outfile, false)) {
+			std::cerr<<"Error while switching to input file \""<<newFiles[i].path<<"\". Aborting..."<<std::endl;
+			exit(1);
+		}
+		if(not processEntries(objectManager)) {
+			exit(1);
+		}
+		if(not objectManager->finish()) {
+			std::cerr<<"Problem when writing TObjects and/or closing output file."<<std::endl;
+			exit(1);
+		}
+		delete infile;
+		delete outfile;
+	}
 
+	bool success = not ABORT;
+	if(success) {
+		std::vector<std::string> mergeFileNames;
+		if(not rebuild) {
+			mergeFileNames.push_back(outfilename);
+		}
+		mergeFileNames.insert(mergeFileNames.end(), partFileNames.begin(), partFileNames.end());
+		for(unsigned int i = 0; i < newFiles.size(); ++i) {
+			manifest.add(newFiles[i]);
+		}
+		success = mergeOutputs(mergeFileNames, outfilename, &manifest);
+	}
+	for(unsigned int i = 0; i < partFileNames.size(); ++i) {
+		std::remove(partFileNames[i].c_str());
+	}
+	if(not success) {
+		exit(1);
 	}
 
-	if(not objectManager->finish()) {
-		std::cerr<<"Problem when writing TObjects and/or closing output file."<<std::endl;
+}
+
+// Processes only the events of the list, given as "<run> <spill> <event number>"
+// per line with a negative spill for any spill, which are looked up in an
+// index made by buildEventIndex and read by entry.
+void treereaderPick(std::string indexfilename, std::string eventlistfilename, std::string outfilename, std::string configfilename = "../config/default.yaml") {
+
+	new TApplication("app", 0, 0);
+
+	gStyle->SetPalette(1);
+	gStyle->SetCanvasColor(10);
+	gStyle->SetPadColor(10);
+
+	antok::EventIndex eventIndex(indexfilename);
+	if(not eventIndex.open()) {
+		exit(1);
+	}
+	std::ifstream eventList(eventlistfilename.c_str());
+	if(not eventList) {
+		std::cerr<<"Could not open event list \""<<eventlistfilename<<"\". Aborting..."<<std::endl;
+		exit(1);
+	}
+	std::map<std::string, std::vector<Long64_t> > entries;
+	Int_t run = 0;
+	Int_t spill = 0;
+	Long64_t eventNumber = 0;
+	unsigned int nRequested = 0;
+	unsigned int nFound = 0;
+	while(eventList>>run>>spill>>eventNumber) {
+		++nRequested;
+		std::vector<antok::EventIndex::eventLocation> locations;
+		if(not eventIndex.find(run, spill, eventNumber, locations)) {
+			std::cerr<<"Warning: event "<<eventNumber<<" of run "<<run<<" (spill "<<spill<<") not found in the index."<<std::endl;
+			continue;
+		}
+		for(unsigned int i = 0; i < locations.size(); ++i) {
+			entries[locations[i].fileName].push_back(locations[i].entry);
+		}
+		++nFound;
+	}
+	if(entries.empty()) {
+		std::cerr<<"None of the "<<nRequested<<" events found. Aborting..."<<std::endl;
+		exit(1);
+	}
+
+	antok::ObjectManager* objectManager = antok::ObjectManager::instance();
+	antok::Initializer* initializer = antok::Initializer::instance();
+	if(not initializer->readConfigFile(configfilename)) {
+		std::cerr<<"Could not open config file. Aborting..."<<std::endl;
+		exit(1);
 	}
 
+	// with several input files every one gets its own output, merged at the end
+	std::vector<std::string> partFileNames;
+	for(std::map<std::string, std::vector<Long64_t> >::iterator entries_it = entries.begin(); entries_it != entries.end() and not ABORT; ++entries_it) {
+		std::string partFileName = outfilename;
+		if(entries.size() > 1) {
+			std::stringstream strStr;
+			strStr<<outfilename<<".part"<<partFileNames.size();
+			partFileName = strStr.str();
+		}
+		TFile* infile = TFile::Open(entries_it->first.c_str(), "READ");
+		TFile* outfile = TFile::Open(partFileName.c_str(), (entries.size() > 1) ? "RECREATE" : "NEW");
+		if(infile == 0 or outfile == 0) {
+			std::cerr<<"Could not open \""<<entries_it->first<<"\" or \""<<partFileName<<"\". Aborting..."<<std::endl;
+			exit(1);
+		}
+		if(partFileNames.empty()) {
+			assert(objectManager->setInFile(infile));
+			assert(objectManager->setOutFile(outfile));
+			// the listed entries are read directly, nothing to scale up
+			objectManager->disablePreview();
+			// the caches expect every entry in order
+			if(not (initializer->initAll() and initializer->canSwitchFiles())) {
+				std::cerr<<"Error while initializing. Aborting..."<<std::endl;
+				exit(1);
+			}
+		} else if(not initializer->switchFiles(infile, outfile, false)) {
+			std::cerr<<"Error while switching to input file \""<<entries_it->first<<"\". Aborting..."<<std::endl;
+			exit(1);
+		}
+		partFileNames.push_back(partFileName);
+		std::vector<Long64_t>& fileEntries = entries_it->second;
+		std::sort(fileEntries.begin(), fileEntries.end());
+		fileEntries.erase(std::unique(fileEntries.begin(), fileEntries.end()), fileEntries.end());
+		for(unsigned int i = 0; i < fileEntries.size() and not ABORT; ++i) {
+			if(not objectManager->processEntry(fileEntries[i])) {
+				std::cerr<<"Could not process entry "<<fileEntries[i]<<" of \""<<entries_it->first<<"\". Aborting..."<<std::endl;
+				exit(1);
+			}
+		}
+		if(not objectManager->finish()) {
+			std::cerr<<"Problem when writing TObjects and/or closing output file."<<std::endl;
+		}
+		delete infile;
+		delete outfile;
+	}
+
+	if(entries.size() > 1) {
+		const bool success = not ABORT and mergeOutputs(partFileNames, outfilename);
+		for(unsigned int i = 0; i < partFileNames.size(); ++i) {
+			std::remove(partFileNames[i].c_str());
+		}
+		if(not success) {
+			exit(1);
+		}
+	}
+	std::cout<<"Processed "<<nFound<<" of "<<nRequested<<" requested events from "<<entries.size()<<" input files."<<std::endl;
+
 }
 
 int main(int argc, char* argv[]) {
 
 	signal(SIGINT, signal_handler);
 
-	if(argc == 1) {
+	if(argc > 1 and std::string(argv[1]) == "--spool") {
+		if(argc == 3) {
+			treereaderDaemon(argv[2]);
+		} else if(argc == 4) {
+			treereaderDaemon(argv[2], argv[3]);
+		} else {
+			std::cerr<<"Usage: "<<argv[0]<<" --spool <spool directory> [config file]"<<std::endl;
+		}
+	} else if(argc > 1 and std::string(argv[1]) == "--incremental") {
+		if(argc >= 5) {
+			treereaderIncremental(argv[2], argv[3], std::vector<std::string>(argv + 4, argv + argc));
+		} else {
+			std::cerr<<"Usage: "<<argv[0]<<" --incremental <cumulative output file> <config file> <input files...>"<<std::endl;
+		}
+	} else if(argc > 1 and std::string(argv[1]) == "--pick") {
+		if(argc == 5) {
+			treereaderPick(argv[2], argv[3], argv[4]);
+		} else if(argc == 6) {
+			treereaderPick(argv[2], argv[3], argv[4], argv[5]);
+		} else {
+			std::cerr<<"Usage: "<<argv[0]<<" --pick <index file> <event list> <output file> [config file]"<<std::endl;
+		}
+	} else if(argc == 1) {
 		treereader();
 	} else if (argc == 3) {
 		treereader(argv[1], argv[2]);